@@ -0,0 +1,782 @@
+/* ========================================================================= */
+/* ------------------------------------------------------------------------- */
+/*!
+  file         dbflatproxy.cc
+  date         October 2026
+  author       agent
+
+  brief        Contains the implementation for DbFlatProxy class.
+
+*//*
+
+ ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ Please read COPYING and README files in root folder
+ ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+/* ------------------------------------------------------------------------- */
+/* ========================================================================= */
+//
+//
+//
+//
+/*  INCLUDES    ------------------------------------------------------------ */
+
+#include "dbflatproxy.h"
+#include "dbmodelprivate.h"
+
+#include <QDateTime>
+
+#include <algorithm>
+
+/*  INCLUDES    ============================================================ */
+//
+//
+//
+//
+/*  DEFINITIONS    --------------------------------------------------------- */
+
+/*  DEFINITIONS    ========================================================= */
+//
+//
+//
+//
+/*  CLASS    --------------------------------------------------------------- */
+
+/**
+ * @class DbFlatProxy
+ *
+ * A replacement for QSortFilterProxyModel for models that have no
+ * children (tables). The mapping is one array with the source row for
+ * each row of the proxy and one with the proxy row for each source row
+ * (-1 for rows that are filtered out), so mapping an index either way
+ * is a lookup and the memory used is two integers for each row.
+ *
+ * Rows are filtered with `filterAcceptsRow()` and sorted with
+ * `lessThan()`, like in QSortFilterProxyModel. Rows inserted in the
+ * source are filtered and, if the proxy is sorted, placed where they
+ * belong in the order; rows whose value in the sort column changed
+ * are moved to their new place, like the dynamic sort of
+ * QSortFilterProxyModel. Changes do not filter the rows again until
+ * next `sort()` or `invalidate()`.
+ */
+
+/* ------------------------------------------------------------------------- */
+bool DbFlatProxy::RowLess::operator() (int left_row, int right_row) const
+{
+    if (b_descending_)
+        qSwap (left_row, right_row);
+    QModelIndex left = source_->index (left_row, column_);
+    QModelIndex right = source_->index (right_row, column_);
+    if (!b_by_row_)
+        return proxy_->lessThan (left, right);
+    if (proxy_->lessThan (left, right))
+        return true;
+    if (proxy_->lessThan (right, left))
+        return false;
+    return b_descending_ ? right_row < left_row : left_row < right_row;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+DbFlatProxy::DbFlatProxy (QObject * parent) :
+    QAbstractProxyModel (parent),
+    rows_(),
+    positions_(),
+    sort_column_(-1),
+    sort_order_(Qt::AscendingOrder),
+    sort_role_(Qt::DisplayRole),
+    sort_cs_(Qt::CaseSensitive),
+    sort_locale_(false),
+#if QT_VERSION >= QT_VERSION_CHECK(5, 2, 0)
+    collator_(),
+#endif
+    saved_(),
+    saved_proxy_()
+{
+    DBMODEL_TRACE_ENTRY;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 2, 0)
+    collator_.setCaseSensitivity (sort_cs_);
+#endif
+    DBMODEL_TRACE_EXIT;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+DbFlatProxy::~DbFlatProxy ()
+{
+    DBMODEL_TRACE_ENTRY;
+    DBMODEL_TRACE_EXIT;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void DbFlatProxy::setSourceModel (QAbstractItemModel * source_model)
+{
+    DBMODEL_TRACE_ENTRY;
+    beginResetModel ();
+
+    QAbstractItemModel * old = sourceModel ();
+    if (old != NULL) {
+        disconnect (old, 0, this, 0);
+    }
+    QAbstractProxyModel::setSourceModel (source_model);
+
+    if (source_model != NULL) {
+        connect (source_model, SIGNAL(modelAboutToBeReset()),
+                 this, SLOT(sourceAboutToBeReset()));
+        connect (source_model, SIGNAL(modelReset()),
+                 this, SLOT(sourceReset()));
+        connect (source_model, SIGNAL(layoutAboutToBeChanged()),
+                 this, SLOT(sourceLayoutAboutToBeChanged()));
+        connect (source_model, SIGNAL(layoutChanged()),
+                 this, SLOT(sourceLayoutChanged()));
+        connect (source_model, SIGNAL(dataChanged(QModelIndex,QModelIndex)),
+                 this, SLOT(sourceDataChanged(QModelIndex,QModelIndex)));
+        connect (source_model, SIGNAL(headerDataChanged(Qt::Orientation,int,int)),
+                 this, SLOT(sourceHeaderDataChanged(Qt::Orientation,int,int)));
+        connect (source_model, SIGNAL(rowsInserted(QModelIndex,int,int)),
+                 this, SLOT(sourceRowsInserted(QModelIndex,int,int)));
+        connect (source_model, SIGNAL(rowsAboutToBeRemoved(QModelIndex,int,int)),
+                 this, SLOT(sourceRowsAboutToBeRemoved(QModelIndex,int,int)));
+        connect (source_model, SIGNAL(rowsRemoved(QModelIndex,int,int)),
+                 this, SLOT(sourceRowsRemoved(QModelIndex,int,int)));
+        connect (source_model, SIGNAL(rowsAboutToBeMoved(QModelIndex,int,int,QModelIndex,int)),
+                 this, SLOT(sourceLayoutAboutToBeChanged()));
+        connect (source_model, SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)),
+                 this, SLOT(sourceLayoutChanged()));
+
+        // the columns are not mapped; the proxy starts over
+        connect (source_model, SIGNAL(columnsAboutToBeInserted(QModelIndex,int,int)),
+                 this, SLOT(sourceAboutToBeReset()));
+        connect (source_model, SIGNAL(columnsInserted(QModelIndex,int,int)),
+                 this, SLOT(sourceReset()));
+        connect (source_model, SIGNAL(columnsAboutToBeRemoved(QModelIndex,int,int)),
+                 this, SLOT(sourceAboutToBeReset()));
+        connect (source_model, SIGNAL(columnsRemoved(QModelIndex,int,int)),
+                 this, SLOT(sourceReset()));
+    }
+
+    rebuild ();
+    endResetModel ();
+    DBMODEL_TRACE_EXIT;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The sort is stable: rows that compare equal keep their source order,
+ * in both directions.
+ *
+ * @param column the column to sort on; -1 restores source order
+ * @param order the direction
+ */
+void DbFlatProxy::sort (int column, Qt::SortOrder order)
+{
+    DBMODEL_TRACE_ENTRY;
+    sort_column_ = column;
+    sort_order_ = order;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 2, 0)
+    // follow the locale that is current when the user sorts
+    collator_.setLocale (QLocale ());
+#endif
+    beginLayout ();
+    rebuild ();
+    endLayout ();
+    DBMODEL_TRACE_EXIT;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Used by models that sort the rows by their own means (see
+ * DbModelSortKeys). The rows that are filtered out are dropped from
+ * the list and the rest become the mapping of the proxy, in one layout
+ * change; nothing is compared here. The list must hold each row of the
+ * source model once, otherwise the proxy sorts the rows itself.
+ *
+ * @param column the column the rows were sorted on
+ * @param order the direction
+ * @param source_rows all the rows of the source model in sorted order
+ */
+void DbFlatProxy::sortAs (
+        int column, Qt::SortOrder order, const QVector<int> & source_rows)
+{
+    DBMODEL_TRACE_ENTRY;
+    if (source_rows.count () != positions_.count ()) {
+        DbFlatProxy::sort (column, order);
+        DBMODEL_TRACE_EXIT;
+        return;
+    }
+
+    sort_column_ = column;
+    sort_order_ = order;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 2, 0)
+    collator_.setLocale (QLocale ());
+#endif
+    beginLayout ();
+    QVector<int> rows;
+    rows.reserve (rows_.count ());
+    foreach (int source_row, source_rows) {
+        if (positions_.at (source_row) != -1)
+            rows.append (source_row);
+    }
+    rows_ = rows;
+    rebuildPositions ();
+    endLayout ();
+    DBMODEL_TRACE_EXIT;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void DbFlatProxy::invalidate ()
+{
+    DBMODEL_TRACE_ENTRY;
+    beginLayout ();
+    rebuild ();
+    endLayout ();
+    DBMODEL_TRACE_EXIT;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+QModelIndex DbFlatProxy::mapFromSource (const QModelIndex & source_index) const
+{
+    if (!source_index.isValid ())
+        return QModelIndex ();
+    int row = source_index.row ();
+    if ((row < 0) || (row >= positions_.count ()))
+        return QModelIndex ();
+    int proxy_row = positions_.at (row);
+    if (proxy_row == -1)
+        return QModelIndex ();
+    return createIndex (proxy_row, source_index.column ());
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+QModelIndex DbFlatProxy::mapToSource (const QModelIndex & proxy_index) const
+{
+    QAbstractItemModel * source = sourceModel ();
+    if (!proxy_index.isValid () || (source == NULL))
+        return QModelIndex ();
+    int row = proxy_index.row ();
+    if ((row < 0) || (row >= rows_.count ()))
+        return QModelIndex ();
+    return source->index (rows_.at (row), proxy_index.column ());
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+QModelIndex DbFlatProxy::index (
+        int row, int column, const QModelIndex & parent) const
+{
+    if (parent.isValid () ||
+            (row < 0) || (row >= rows_.count ()) ||
+            (column < 0) || (column >= columnCount ()))
+        return QModelIndex ();
+    return createIndex (row, column);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+QModelIndex DbFlatProxy::parent (const QModelIndex &) const
+{
+    return QModelIndex ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+int DbFlatProxy::rowCount (const QModelIndex & parent) const
+{
+    if (parent.isValid ())
+        return 0;
+    return rows_.count ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+int DbFlatProxy::columnCount (const QModelIndex & parent) const
+{
+    QAbstractItemModel * source = sourceModel ();
+    if (parent.isValid () || (source == NULL))
+        return 0;
+    return source->columnCount ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+bool DbFlatProxy::hasChildren (const QModelIndex & parent) const
+{
+    if (parent.isValid ())
+        return false;
+    return !rows_.isEmpty () || canFetchMore (parent);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+bool DbFlatProxy::canFetchMore (const QModelIndex & parent) const
+{
+    QAbstractItemModel * source = sourceModel ();
+    if (parent.isValid () || (source == NULL))
+        return false;
+    return source->canFetchMore (QModelIndex ());
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void DbFlatProxy::fetchMore (const QModelIndex & parent)
+{
+    QAbstractItemModel * source = sourceModel ();
+    if (parent.isValid () || (source == NULL))
+        return;
+    source->fetchMore (QModelIndex ());
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The rows are inserted in the source before the source row that
+ * corresponds to \b row (at the end if \b row is past the last row);
+ * they will show at the end of the proxy.
+ */
+bool DbFlatProxy::insertRows (int row, int count, const QModelIndex & parent)
+{
+    QAbstractItemModel * source = sourceModel ();
+    if (parent.isValid () || (source == NULL) ||
+            (row < 0) || (row > rows_.count ()) || (count < 1))
+        return false;
+    int source_row = row == rows_.count () ?
+                source->rowCount () : rows_.at (row);
+    return source->insertRows (source_row, count);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The rows of the proxy may be scattered in the source; they are
+ * removed from the source in blocks of adjacent rows, last block first.
+ */
+bool DbFlatProxy::removeRows (int row, int count, const QModelIndex & parent)
+{
+    bool b_ret = false;
+    for (;;) {
+        QAbstractItemModel * source = sourceModel ();
+        if (parent.isValid () || (source == NULL) ||
+                (row < 0) || (count < 1) || (row + count > rows_.count ()))
+            break;
+
+        QVector<int> source_rows = rows_.mid (row, count);
+        std::sort (source_rows.begin (), source_rows.end ());
+
+        b_ret = true;
+        int last = source_rows.count () - 1;
+        while (last >= 0) {
+            int first = last;
+            while ((first > 0) &&
+                   (source_rows.at (first - 1) == source_rows.at (first) - 1)) {
+                --first;
+            }
+            if (!source->removeRows (
+                        source_rows.at (first), last - first + 1)) {
+                b_ret = false;
+                break;
+            }
+            last = first - 1;
+        }
+        break;
+    }
+    return b_ret;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Null values sort first; numbers, dates and times are compared by
+ * value and anything else as text, using the case sensitivity and the
+ * locale settings of the proxy.
+ *
+ * @param left index in the source model
+ * @param right index in the source model
+ * @return true if the left value sorts before the right one
+ */
+bool DbFlatProxy::lessThan (
+        const QModelIndex & left, const QModelIndex & right) const
+{
+    QVariant l = left.data (sort_role_);
+    QVariant r = right.data (sort_role_);
+    if (l.isNull () || r.isNull ())
+        return l.isNull () && !r.isNull ();
+
+    switch (l.type ()) {
+    case QVariant::Bool:
+    case QVariant::Int:
+    case QVariant::LongLong:
+        return l.toLongLong () < r.toLongLong ();
+    case QVariant::UInt:
+    case QVariant::ULongLong:
+        return l.toULongLong () < r.toULongLong ();
+    case QVariant::Double:
+        return l.toDouble () < r.toDouble ();
+    case QVariant::Date:
+        return l.toDate () < r.toDate ();
+    case QVariant::Time:
+        return l.toTime () < r.toTime ();
+    case QVariant::DateTime:
+        return l.toDateTime () < r.toDateTime ();
+    default:
+        if (sort_locale_) {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 2, 0)
+            return collator_.compare (l.toString (), r.toString ()) < 0;
+#else
+            if (sort_cs_ == Qt::CaseInsensitive)
+                return QString::localeAwareCompare (
+                            l.toString ().toCaseFolded (),
+                            r.toString ().toCaseFolded ()) < 0;
+            return QString::localeAwareCompare (
+                        l.toString (), r.toString ()) < 0;
+#endif
+        }
+        return QString::compare (l.toString (), r.toString (), sort_cs_) < 0;
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+bool DbFlatProxy::filterAcceptsRow (int, const QModelIndex &) const
+{
+    return true;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+DbFlatProxy::RowLess DbFlatProxy::rowLess () const
+{
+    RowLess less;
+    less.proxy_ = this;
+    less.source_ = sourceModel ();
+    less.column_ = sort_column_;
+    less.b_descending_ = sort_order_ == Qt::DescendingOrder;
+    less.b_by_row_ = false;
+    return less;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void DbFlatProxy::rebuild ()
+{
+    rows_.clear ();
+    QAbstractItemModel * source = sourceModel ();
+    if (source != NULL) {
+        int i_max = source->rowCount ();
+        rows_.reserve (i_max);
+        for (int i = 0; i < i_max; ++i) {
+            if (filterAcceptsRow (i, QModelIndex ()))
+                rows_.append (i);
+        }
+        if ((sort_column_ >= 0) && (sort_column_ < source->columnCount ())) {
+            std::stable_sort (rows_.begin (), rows_.end (), rowLess ());
+        }
+    }
+    rebuildPositions ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The rows are taken out of the proxy and placed back with a binary
+ * search among the other rows, that are still sorted, all in one
+ * layout change. If a large part of the proxy changed the rows are
+ * sorted again with `sort()`, so a model can use its own means.
+ *
+ * @param first the first source row that changed
+ * @param last the last source row that changed
+ */
+void DbFlatProxy::moveChanged (int first, int last)
+{
+    QAbstractItemModel * source = sourceModel ();
+    if ((source == NULL) || (sort_column_ >= source->columnCount ()))
+        return;
+
+    last = qMin (last, positions_.count () - 1);
+    QVector<int> moved;
+    for (int i = first; i <= last; ++i) {
+        if (positions_.at (i) != -1)
+            moved.append (i);
+    }
+    if (moved.isEmpty ())
+        return;
+    if (moved.count () > rows_.count () / DBFLATPROXY_MOVE_FRACTION) {
+        sort (sort_column_, sort_order_);
+        return;
+    }
+
+    beginLayout ();
+    QVector<int> kept;
+    kept.reserve (rows_.count ());
+    foreach (int source_row, rows_) {
+        if ((source_row < first) || (source_row > last))
+            kept.append (source_row);
+    }
+    rows_ = kept;
+
+    RowLess less = rowLess ();
+    less.b_by_row_ = true;
+    foreach (int source_row, moved) {
+        rows_.insert (std::lower_bound (
+                          rows_.begin (), rows_.end (), source_row, less),
+                      source_row);
+    }
+    rebuildPositions ();
+    endLayout ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void DbFlatProxy::rebuildPositions ()
+{
+    QAbstractItemModel * source = sourceModel ();
+    positions_.fill (-1, source == NULL ? 0 : source->rowCount ());
+    int i_max = rows_.count ();
+    for (int i = 0; i < i_max; ++i) {
+        positions_[rows_.at (i)] = i;
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void DbFlatProxy::beginLayout ()
+{
+    emit layoutAboutToBeChanged ();
+    saved_proxy_ = persistentIndexList ();
+    saved_.clear ();
+    foreach (const QModelIndex & idx, saved_proxy_) {
+        saved_.append (QPersistentModelIndex (mapToSource (idx)));
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void DbFlatProxy::endLayout ()
+{
+    QModelIndexList updated;
+    foreach (const QPersistentModelIndex & idx, saved_) {
+        updated.append (mapFromSource (idx));
+    }
+    changePersistentIndexList (saved_proxy_, updated);
+    saved_.clear ();
+    saved_proxy_.clear ();
+    emit layoutChanged ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void DbFlatProxy::sourceAboutToBeReset ()
+{
+    beginResetModel ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void DbFlatProxy::sourceReset ()
+{
+    rebuild ();
+    endResetModel ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void DbFlatProxy::sourceLayoutAboutToBeChanged ()
+{
+    beginLayout ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void DbFlatProxy::sourceLayoutChanged ()
+{
+    rebuild ();
+    endLayout ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void DbFlatProxy::sourceDataChanged (
+        const QModelIndex & top_left, const QModelIndex & bottom_right)
+{
+    if (!top_left.isValid () || !bottom_right.isValid ())
+        return;
+
+    if ((sort_column_ >= top_left.column ()) &&
+            (sort_column_ <= bottom_right.column ())) {
+        moveChanged (top_left.row (), bottom_right.row ());
+    }
+
+    int first = -1;
+    int last = -1;
+    int i_max = qMin (bottom_right.row (), positions_.count () - 1);
+    for (int i = top_left.row (); i <= i_max; ++i) {
+        int proxy_row = positions_.at (i);
+        if (proxy_row == -1)
+            continue;
+        if ((first == -1) || (proxy_row < first))
+            first = proxy_row;
+        if (proxy_row > last)
+            last = proxy_row;
+    }
+    if (first == -1)
+        return;
+
+    emit dataChanged (
+                createIndex (first, top_left.column ()),
+                createIndex (last, bottom_right.column ()));
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void DbFlatProxy::sourceHeaderDataChanged (
+        Qt::Orientation orientation, int first, int last)
+{
+    if (orientation == Qt::Horizontal) {
+        emit headerDataChanged (orientation, first, last);
+    } else if (!rows_.isEmpty ()) {
+        emit headerDataChanged (orientation, 0, rows_.count () - 1);
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The new rows that pass the filter are added at the end of the proxy
+ * or, if the proxy is sorted, each one is placed with a binary search
+ * among the rows that are already sorted; new rows that land next
+ * to each other are inserted as one block. Equal values keep the
+ * order of the source rows, as if all the rows were sorted again.
+ */
+void DbFlatProxy::sourceRowsInserted (
+        const QModelIndex & parent, int first, int last)
+{
+    if (parent.isValid ())
+        return;
+
+    // source rows after the insertion point moved down
+    int count = last - first + 1;
+    int i_max = rows_.count ();
+    for (int i = 0; i < i_max; ++i) {
+        if (rows_.at (i) >= first)
+            rows_[i] += count;
+    }
+    positions_.insert (first, count, -1);
+
+    QVector<int> added;
+    for (int i = first; i <= last; ++i) {
+        if (filterAcceptsRow (i, QModelIndex ()))
+            added.append (i);
+    }
+    if (added.isEmpty ())
+        return;
+
+    QAbstractItemModel * source = sourceModel ();
+    if ((sort_column_ < 0) || (sort_column_ >= source->columnCount ())) {
+        beginInsertRows (QModelIndex (), i_max, i_max + added.count () - 1);
+        foreach (int source_row, added) {
+            positions_[source_row] = rows_.count ();
+            rows_.append (source_row);
+        }
+        endInsertRows ();
+        return;
+    }
+
+    RowLess less = rowLess ();
+    less.b_by_row_ = true;
+    std::sort (added.begin (), added.end (), less);
+
+    // blocks are inserted starting with the last one, so the rows
+    // before the insertion point keep their place
+    int end = added.count () - 1;
+    while (end >= 0) {
+        int row = std::lower_bound (
+                    rows_.begin (), rows_.end (),
+                    added.at (end), less) - rows_.begin ();
+        int start = end;
+        while ((start > 0) && ((row == 0) ||
+                               less (rows_.at (row - 1), added.at (start - 1)))) {
+            --start;
+        }
+
+        beginInsertRows (QModelIndex (), row, row + end - start);
+        rows_.insert (row, end - start + 1, -1);
+        for (int i = start; i <= end; ++i) {
+            rows_[row + i - start] = added.at (i);
+        }
+        int j_max = rows_.count ();
+        for (int j = row; j < j_max; ++j) {
+            positions_[rows_.at (j)] = j;
+        }
+        endInsertRows ();
+
+        end = start - 1;
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The rows are removed from the proxy before they leave the source,
+ * in blocks of adjacent proxy rows.
+ */
+void DbFlatProxy::sourceRowsAboutToBeRemoved (
+        const QModelIndex & parent, int first, int last)
+{
+    if (parent.isValid ())
+        return;
+
+    QVector<int> removed;
+    int i_max = qMin (last, positions_.count () - 1);
+    for (int i = first; i <= i_max; ++i) {
+        if (positions_.at (i) != -1)
+            removed.append (positions_.at (i));
+    }
+    std::sort (removed.begin (), removed.end ());
+
+    int end = removed.count () - 1;
+    while (end >= 0) {
+        int start = end;
+        while ((start > 0) &&
+               (removed.at (start - 1) == removed.at (start) - 1)) {
+            --start;
+        }
+        beginRemoveRows (QModelIndex (), removed.at (start), removed.at (end));
+        rows_.remove (removed.at (start), end - start + 1);
+        rebuildPositions ();
+        endRemoveRows ();
+        end = start - 1;
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void DbFlatProxy::sourceRowsRemoved (
+        const QModelIndex & parent, int first, int last)
+{
+    if (parent.isValid ())
+        return;
+
+    // source rows after the removed ones moved up
+    int count = last - first + 1;
+    int i_max = rows_.count ();
+    for (int i = 0; i < i_max; ++i) {
+        if (rows_.at (i) > last)
+            rows_[i] -= count;
+    }
+    rebuildPositions ();
+}
+/* ========================================================================= */
+
+/*  CLASS    =============================================================== */
+//
+//
+//
+//
+void DbFlatProxy::anchorVtable() const {}
+/* ------------------------------------------------------------------------- */
+/* ========================================================================= */
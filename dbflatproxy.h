@@ -0,0 +1,343 @@
+/* ========================================================================= */
+/* ------------------------------------------------------------------------- */
+/*!
+  file         dbflatproxy.h
+  date         October 2026
+  author       agent
+
+  brief        Contains the definition for DbFlatProxy class.
+
+*//*
+
+ ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ Please read COPYING and README files in root folder
+ ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+/* ------------------------------------------------------------------------- */
+/* ========================================================================= */
+#ifndef DBFLATPROXY_H
+#define DBFLATPROXY_H
+//
+//
+//
+//
+/*  INCLUDES    ------------------------------------------------------------ */
+
+#include <dbmodel/dbmodel-config.h>
+
+#include <QAbstractProxyModel>
+#include <QPersistentModelIndex>
+#include <QVector>
+#include <QList>
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 2, 0)
+#   include <QCollator>
+#endif
+
+/*  INCLUDES    ============================================================ */
+//
+//
+//
+//
+/*  DEFINITIONS    --------------------------------------------------------- */
+
+//! Changed rows are moved one by one up to 1/N of the rows in the proxy.
+#define DBFLATPROXY_MOVE_FRACTION 8
+
+/*  DEFINITIONS    ========================================================= */
+//
+//
+//
+//
+/*  CLASS    --------------------------------------------------------------- */
+
+//! Sorts and filters the rows of a flat (table) model.
+class DBMODEL_EXPORT DbFlatProxy : public QAbstractProxyModel {
+    Q_OBJECT
+
+    //
+    //
+    //
+    //
+    /*  DEFINITIONS    ----------------------------------------------------- */
+
+    //! Orders source rows using `lessThan()`.
+    struct RowLess {
+        const DbFlatProxy * proxy_; /**< the proxy that compares */
+        const QAbstractItemModel * source_; /**< the source model */
+        int column_; /**< the column that is compared */
+        bool b_descending_; /**< reverse the order */
+        bool b_by_row_; /**< equal values keep the order of the source rows */
+
+        //! Compare two source rows.
+        bool
+        operator() (
+                int left_row,
+                int right_row) const;
+    };
+
+    /*  DEFINITIONS    ===================================================== */
+    //
+    //
+    //
+    //
+    /*  DATA    ------------------------------------------------------------ */
+
+    QVector<int> rows_; /**< the source row for each row of the proxy */
+    QVector<int> positions_; /**< the proxy row for each source row (-1 if filtered out) */
+    int sort_column_; /**< the column used for sorting (-1 for source order) */
+    Qt::SortOrder sort_order_; /**< the direction of the sort */
+    int sort_role_; /**< the role used to read values when sorting */
+    Qt::CaseSensitivity sort_cs_; /**< are texts compared with case sensitivity? */
+    bool sort_locale_; /**< are texts compared using the locale? */
+#if QT_VERSION >= QT_VERSION_CHECK(5, 2, 0)
+    QCollator collator_; /**< compares texts when sort_locale_ is set */
+#endif
+    QList<QPersistentModelIndex> saved_; /**< source indexes of persistent indexes during a layout change */
+    QModelIndexList saved_proxy_; /**< persistent indexes during a layout change */
+
+    /*  DATA    ============================================================ */
+    //
+    //
+    //
+    //
+    /*  FUNCTIONS    ------------------------------------------------------- */
+
+public:
+
+    //! Constructor.
+    explicit DbFlatProxy (
+            QObject * parent = NULL);
+
+    //! destructor
+    virtual ~DbFlatProxy ();
+
+    //! Change the model that provides the rows.
+    virtual void
+    setSourceModel (
+            QAbstractItemModel * source_model);
+
+    //! Sort the rows on a column (-1 restores source order).
+    virtual void
+    sort (
+            int column,
+            Qt::SortOrder order = Qt::AscendingOrder);
+
+    //! The column used for sorting (-1 for source order).
+    int
+    sortColumn () const {
+        return sort_column_;
+    }
+
+    //! The direction of the sort.
+    Qt::SortOrder
+    sortOrder () const {
+        return sort_order_;
+    }
+
+    //! The role used to read values when sorting.
+    int
+    sortRole () const {
+        return sort_role_;
+    }
+
+    //! Change the role used to read values when sorting.
+    void
+    setSortRole (
+            int value) {
+        sort_role_ = value;
+    }
+
+    //! Are texts compared with case sensitivity?
+    Qt::CaseSensitivity
+    sortCaseSensitivity () const {
+        return sort_cs_;
+    }
+
+    //! Change the way texts are compared.
+    void
+    setSortCaseSensitivity (
+            Qt::CaseSensitivity value) {
+        sort_cs_ = value;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 2, 0)
+        collator_.setCaseSensitivity (value);
+#endif
+    }
+
+    //! Are texts compared using the locale?
+    bool
+    isSortLocaleAware () const {
+        return sort_locale_;
+    }
+
+    //! Change the way texts are compared.
+    void
+    setSortLocaleAware (
+            bool value) {
+        sort_locale_ = value;
+    }
+
+    //! Filter and sort all the rows again.
+    void
+    invalidate ();
+
+    virtual QModelIndex
+    mapFromSource (
+            const QModelIndex & source_index) const;
+
+    virtual QModelIndex
+    mapToSource (
+            const QModelIndex & proxy_index) const;
+
+    virtual QModelIndex
+    index (
+            int row,
+            int column,
+            const QModelIndex & parent = QModelIndex ()) const;
+
+    virtual QModelIndex
+    parent (
+            const QModelIndex & child) const;
+
+    virtual int
+    rowCount (
+            const QModelIndex & parent = QModelIndex ()) const;
+
+    virtual int
+    columnCount (
+            const QModelIndex & parent = QModelIndex ()) const;
+
+    virtual bool
+    hasChildren (
+            const QModelIndex & parent = QModelIndex ()) const;
+
+    virtual bool
+    canFetchMore (
+            const QModelIndex & parent) const;
+
+    virtual void
+    fetchMore (
+            const QModelIndex & parent);
+
+    virtual bool
+    insertRows (
+            int row,
+            int count,
+            const QModelIndex & parent = QModelIndex ());
+
+    virtual bool
+    removeRows (
+            int row,
+            int count,
+            const QModelIndex & parent = QModelIndex ());
+
+protected:
+
+    //! Sort the rows in an order computed elsewhere.
+    void
+    sortAs (
+            int column,
+            Qt::SortOrder order,
+            const QVector<int> & source_rows);
+
+    //! Tell if the first value sorts before the second one.
+    virtual bool
+    lessThan (
+            const QModelIndex & left,
+            const QModelIndex & right) const;
+
+    //! Tell if a source row is shown.
+    virtual bool
+    filterAcceptsRow (
+            int source_row,
+            const QModelIndex & source_parent) const;
+
+private:
+
+    //! The comparator for current sort column and order.
+    RowLess
+    rowLess () const;
+
+    //! Compute the rows from scratch.
+    void
+    rebuild ();
+
+    //! Place source rows whose values changed where they belong.
+    void
+    moveChanged (
+            int first,
+            int last);
+
+    //! Compute `positions_` from `rows_`.
+    void
+    rebuildPositions ();
+
+    //! Save persistent indexes and announce a layout change.
+    void
+    beginLayout ();
+
+    //! Restore persistent indexes and end a layout change.
+    void
+    endLayout ();
+
+private slots:
+
+    void
+    sourceAboutToBeReset ();
+
+    void
+    sourceReset ();
+
+    void
+    sourceLayoutAboutToBeChanged ();
+
+    void
+    sourceLayoutChanged ();
+
+    void
+    sourceDataChanged (
+            const QModelIndex & top_left,
+            const QModelIndex & bottom_right);
+
+    void
+    sourceHeaderDataChanged (
+            Qt::Orientation orientation,
+            int first,
+            int last);
+
+    void
+    sourceRowsInserted (
+            const QModelIndex & parent,
+            int first,
+            int last);
+
+    void
+    sourceRowsAboutToBeRemoved (
+            const QModelIndex & parent,
+            int first,
+            int last);
+
+    void
+    sourceRowsRemoved (
+            const QModelIndex & parent,
+            int first,
+            int last);
+
+    /*  FUNCTIONS    ======================================================= */
+    //
+    //
+    //
+    //
+public: virtual void anchorVtable() const;
+}; /* class DbFlatProxy */
+
+/*  CLASS    =============================================================== */
+//
+//
+//
+//
+
+
+#endif // DBFLATPROXY_H
+/* ------------------------------------------------------------------------- */
+/* ========================================================================= */
@@ -9,6 +9,7 @@
 
 #include "dbmodel.h"
 #include "dbmodelprivate.h"
+#include "dbmodelsortkeys.h"
 
 #include <dbstruct/dbtable.h>
 #include <dbstruct/dbview.h>
@@ -38,11 +39,13 @@
  * \param parent the parent QObject
  */
 DbModel::DbModel(DbStruct * db, DbTaew * meta, QObject * parent) :
-    QSortFilterProxyModel(parent),
+    DbFlatProxy(parent),
     impl(new DbModelPrivate (db, meta, this)),
-    filter_()
+    filter_(),
+    sort_keys_(new DbModelSortKeys ())
 {
     DBMODEL_TRACE_ENTRY;
+    connectSortKeys ();
     setSourceModel(impl);
     setSortCaseSensitivity (Qt::CaseInsensitive);
     DBMODEL_TRACE_EXIT;
@@ -59,11 +62,13 @@ DbModel::DbModel(DbStruct * db, DbTaew * meta, QObject * parent) :
  * \param parent the parent QObject
  */
 DbModel::DbModel(DbStruct * db, int component, QObject * parent) :
-    QSortFilterProxyModel(parent),
+    DbFlatProxy(parent),
     impl(new DbModelPrivate (db, component, this)),
-    filter_()
+    filter_(),
+    sort_keys_(new DbModelSortKeys ())
 {
     DBMODEL_TRACE_ENTRY;
+    connectSortKeys ();
     setSourceModel(impl);
     setSortCaseSensitivity (Qt::CaseInsensitive);
     DBMODEL_TRACE_EXIT;
@@ -77,6 +82,7 @@ DbModel::DbModel(DbStruct * db, int component, QObject * parent) :
 DbModel::~DbModel()
 {
     DBMODEL_TRACE_ENTRY;
+    delete sort_keys_;
     DBMODEL_TRACE_EXIT;
 }
 /* ========================================================================= */
@@ -319,6 +325,24 @@ int DbModel::findTable (const QString &table) const
 }
 /* ========================================================================= */
 
+/* ------------------------------------------------------------------------- */
+/**
+ * Unlike `record()` the values are not copied; they are read
+ * from the model when requested. The view should not be kept after
+ * the model is selected again.
+ *
+ * @param row the row in this model
+ * @return the view (invalid if the row is out of bounds)
+ */
+DbModelRow DbModel::rowView (int row) const
+{
+    QModelIndex inimpl = mapToSource (index (row, 0));
+    if (!inimpl.isValid ())
+        return DbModelRow ();
+    return impl->rowView (inimpl.row ());
+}
+/* ========================================================================= */
+
 /* ------------------------------------------------------------------------- */
 QSqlRecord DbModel::record(int row) const
 {
@@ -327,6 +351,38 @@ QSqlRecord DbModel::record(int row) const
 }
 /* ========================================================================= */
 
+/* ------------------------------------------------------------------------- */
+/**
+ * Intended for exports, printing and reports that read many cells:
+ * the rows are mapped to the internal model once and the internal model
+ * produces all the values in one pass.
+ *
+ * The rows are in the order presented by this model (sorted, filtered).
+ *
+ * @param first_row the first row
+ * @param row_count number of rows
+ * @param columns the columns to read
+ * @param role the role (usually Qt::DisplayRole)
+ * @param values receives `row_count` times `columns.count ()` values
+ * @return false if an index is out of bounds
+ */
+bool DbModel::fetchBlock (
+        int first_row, int row_count, const QList<int> & columns,
+        int role, QVector<QVariant> & values) const
+{
+    values.clear ();
+    if ((first_row < 0) || (row_count < 0) ||
+            (first_row + row_count > rowCount (QModelIndex ())))
+        return false;
+
+    QVector<int> rows (row_count);
+    for (int i = 0; i < row_count; ++i) {
+        rows[i] = mapToSource (index (first_row + i, 0)).row ();
+    }
+    return impl->fetchBlock (rows, columns, role, values);
+}
+/* ========================================================================= */
+
 /* ------------------------------------------------------------------------- */
 void DbModel::reloadHeaders ()
 {
@@ -335,6 +391,184 @@ void DbModel::reloadHeaders ()
 /* ========================================================================= */
 
 /* ------------------------------------------------------------------------- */
+void DbModel::reloadFormats ()
+{
+    impl->reloadFormats ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * @param column the index of the column
+ * @param value the alignment; 0 leaves the alignment to the view
+ * (and to the column callback, if any)
+ * @return false if the index is out of bounds
+ */
+bool DbModel::setColumnAlignment (int column, Qt::Alignment value)
+{
+    QVariant alignment;
+    if (value != 0) {
+        alignment = static_cast<int>(value);
+    }
+    return impl->setColumnAlignment (column, alignment);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+int DbModel::cellCacheSize () const
+{
+    return impl->cellCacheSize ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The internal model keeps the values it returned for the most
+ * recently used cells (all roles), so repeated paints of the same
+ * rows don't compute the values again. The values for a row are
+ * dropped when the row changes and all values are dropped when the
+ * model is selected, filtered or sorted again and when the headers
+ * are reloaded.
+ *
+ * @param value maximum number of values (0 disables the cache)
+ */
+void DbModel::setCellCacheSize (int value)
+{
+    impl->setCellCacheSize (value);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+bool DbModel::columnarStore () const
+{
+    return impl->columnarStore ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * When enabled, the rows of the main table are copied into typed
+ * vectors (one for each column) the first time they are read
+ * and all later reads, including the ones made while sorting,
+ * use the copy. The copy is dropped when the model is selected
+ * again and single rows are refreshed when they are edited.
+ *
+ * Filtering is not affected, as it is performed by the database.
+ *
+ * @param b_enable true to keep the copy
+ */
+void DbModel::setColumnarStore (bool b_enable)
+{
+    impl->setColumnarStore (b_enable);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+DbModelTbl::ForeignMode DbModel::foreignMode () const
+{
+    return impl->foreignMode ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * By default (DbModelTbl::FM_LOOKUP) the secondary tables are loaded
+ * in memory and the values for foreign columns are searched there.
+ * In DbModelTbl::FM_JOIN mode the main query joins the secondary
+ * tables and the values come back with the rows of the main table.
+ *
+ * In join mode the filter should qualify the columns with the name
+ * of the main table if secondary tables have columns with same name.
+ *
+ * Other settings of the model are kept; a selected model is selected again.
+ *
+ * @param value the new mode
+ */
+void DbModel::setForeignMode (DbModelTbl::ForeignMode value)
+{
+    impl->setForeignMode (value);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * In DbModelTbl::LM_ONDEMAND mode the secondary table starts empty and
+ * the rows are loaded in batches (`WHERE key IN (...)`) as the rows
+ * of the main table that reference them are displayed.
+ *
+ * DbModelTbl::LM_ASYNC mode is similar but the rows are loaded in a
+ * worker thread; the cells show DbModelManager::getPlaceholder() until
+ * the values arrive.
+ *
+ * @param value the new mode
+ * @param table_index the index of the secondary table (0 is main table)
+ * @return false if the index is out of bounds or is the main table
+ */
+bool DbModel::setLookupMode (DbModelTbl::LookupMode value, int table_index)
+{
+    return impl->setLookupMode (value, table_index);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+bool DbModel::setLookupMode (
+        DbModelTbl::LookupMode value, const QString & table)
+{
+    return impl->setLookupMode (value, table);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * By default all tables are selected each time the model is selected.
+ * Secondary tables may instead be selected again only after a number
+ * of milliseconds (DbModelTbl::RP_TTL), only when a query returns a
+ * different value (DbModelTbl::RP_VERSION) or only when `refreshTable()`
+ * is called (DbModelTbl::RP_MANUAL). The policy applies to all models
+ * that share the table.
+ *
+ * @param value the new policy
+ * @param table_index the index of the secondary table (0 is main table)
+ * @param argument the number of milliseconds or the version statement
+ * @return false if the index is out of bounds or is the main table
+ */
+bool DbModel::setRefreshPolicy (
+        DbModelTbl::RefreshPolicy value, int table_index,
+        const QVariant & argument)
+{
+    return impl->setRefreshPolicy (value, table_index, argument);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+bool DbModel::setRefreshPolicy (
+        DbModelTbl::RefreshPolicy value, const QString & table,
+        const QVariant & argument)
+{
+    return impl->setRefreshPolicy (value, table, argument);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+bool DbModel::refreshTable (int table_index)
+{
+    return impl->refreshTable (table_index);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The result of the callback is cached for each row and role
+ * until the row changes (a `dataChanged()` signal covers it) or
+ * the model is selected again. Sorting on a dynamic column also
+ * uses the cached results.
+ *
+ * @param table_index the table (0 for main table)
+ * @param column_index the index of a dynamic column
+ * @param value the callback
+ * @param user_data data passed along to the callback
+ * @return false if the indexes are not valid
+ */
 bool DbModel::setColumnCallback (
         int table_index, int column_index,
         DbColKb value, void * user_data)
@@ -352,6 +586,70 @@ DbColKb DbModel::columnCallback (
 }
 /* ========================================================================= */
 
+/* ------------------------------------------------------------------------- */
+/**
+ * When a dynamic column has a batch callback, the model asks it for
+ * a block of rows at a time (the rows around the one being shown
+ * that were not computed yet) instead of calling the per-row callback
+ * for each row. Callbacks that query the database may then use a
+ * single query for the whole block.
+ *
+ * If the batch callback returns a number of values that is different
+ * from the number of rows, the per-row callback is used.
+ *
+ * @param table_index the table (0 for main table)
+ * @param column_index the index of a dynamic column
+ * @param value the callback (NULL to remove it)
+ * @param user_data data passed along to the callbacks
+ * @return false if the indexes are not valid or the column is not dynamic
+ */
+bool DbModel::setBatchCallback (
+        int table_index, int column_index,
+        DbColBatchKb value, void * user_data)
+{
+    return impl->setBatchCallback (
+                table_index, column_index, value, user_data);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Same as a column callback, but the callback receives a view of
+ * the row instead of a copy of the record, so no record is built
+ * for each call. The row callback takes precedence over the callback
+ * in the column definition; a batch callback takes precedence over both.
+ *
+ * @param table_index the table (0 for main table)
+ * @param column_index the index of a dynamic column
+ * @param value the callback (NULL to remove it)
+ * @param user_data data passed along to the callbacks
+ * @return false if the indexes are not valid or the column is not dynamic
+ */
+bool DbModel::setRowCallback (
+        int table_index, int column_index,
+        DbColRowKb value, void * user_data)
+{
+    return impl->setRowCallback (
+                table_index, column_index, value, user_data);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+DbColRowKb DbModel::rowCallback (
+        int table_index, int column_index)
+{
+    return impl->rowCallback (table_index, column_index);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+DbColBatchKb DbModel::batchCallback (
+        int table_index, int column_index)
+{
+    return impl->batchCallback (table_index, column_index);
+}
+/* ========================================================================= */
+
 /* ------------------------------------------------------------------------- */
 void * DbModel::columnCallbackData ()
 {
@@ -374,9 +672,83 @@ bool DbModel::setCurrentMarker (int row, int column)
 }
 /* ========================================================================= */
 
+/* ------------------------------------------------------------------------- */
+/**
+ * The connections are made before the proxy connects to the internal
+ * model, so the keys are gone by the time the proxy reacts to the
+ * same signal (and possibly sorts again).
+ */
+void DbModel::connectSortKeys ()
+{
+    connect (impl, SIGNAL(modelReset()),
+             this, SLOT(forgetSortKeys()));
+    connect (impl, SIGNAL(layoutChanged()),
+             this, SLOT(forgetSortKeys()));
+    connect (impl, SIGNAL(dataChanged(QModelIndex,QModelIndex)),
+             this, SLOT(forgetSortKeys()));
+    connect (impl, SIGNAL(rowsInserted(QModelIndex,int,int)),
+             this, SLOT(forgetSortKeys()));
+    connect (impl, SIGNAL(rowsRemoved(QModelIndex,int,int)),
+             this, SLOT(forgetSortKeys()));
+    connect (impl, SIGNAL(lookupChanged()),
+             this, SLOT(forgetSortKeys()));
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void DbModel::forgetSortKeys ()
+{
+    sort_keys_->clear ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The values of the column are read once and reduced to keys
+ * (DbModelSortKeys) that are sorted by the keys themselves; the proxy
+ * takes the result as its mapping. The keys are kept until the data
+ * changes, so sorting the same column again (e.g. in the other
+ * direction) does not read the values again.
+ *
+ * Sorting triggered by the proxy itself (after rows are inserted or
+ * the source changed its layout) reads the values for each comparison.
+ *
+ * @param column the column to sort on (-1 restores source order)
+ * @param order the direction
+ */
+void DbModel::sort (int column, Qt::SortOrder order)
+{
+    DBMODEL_TRACE_ENTRY;
+    if ((column >= 0) && !sort_keys_->matches (
+                column, sortRole (),
+                sortCaseSensitivity (), isSortLocaleAware ())) {
+        sort_keys_->build (
+                    impl, column, sortRole (),
+                    sortCaseSensitivity (), isSortLocaleAware ());
+    }
+    if ((column >= 0) && sort_keys_->matches (
+                column, sortRole (),
+                sortCaseSensitivity (), isSortLocaleAware ())) {
+        sortAs (column, order, sort_keys_->sortedRows (order));
+    } else {
+        DbFlatProxy::sort (column, order);
+    }
+    DBMODEL_TRACE_EXIT;
+}
+/* ========================================================================= */
+
 /* ------------------------------------------------------------------------- */
 bool DbModel::lessThan (const QModelIndex &left, const QModelIndex &right) const
 {
+    if (sort_keys_->matches (
+                left.column (), sortRole (),
+                sortCaseSensitivity (), isSortLocaleAware ()) &&
+            (right.column () == left.column ()) &&
+            (left.row () < sort_keys_->count ()) &&
+            (right.row () < sort_keys_->count ())) {
+        return sort_keys_->lessThan (left.row (), right.row ());
+    }
+
     QVariant leftData = sourceModel()->data(left);
     QVariant rightData = sourceModel()->data(right);
 
@@ -387,7 +759,7 @@ bool DbModel::lessThan (const QModelIndex &left, const QModelIndex &right) const
     } else if (leftData.type() == QVariant::Time) {
         return leftData.toTime() < rightData.toTime();
     } else {
-        return QSortFilterProxyModel::lessThan (left, right);
+        return DbFlatProxy::lessThan (left, right);
         /*
         static QRegExp emailPattern("[\\w\\.]*@[\\w\\.]*)");
 
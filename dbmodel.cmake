@@ -22,13 +22,26 @@ macro    (dbmodelInit
         "dbmodel.h"
         "dbmodeltbl.h"
         "dbmodelcol.h"
+        "dbmodelformat.h"
+        "dbmodelrow.h"
+        "dbmodellookup.h"
+        "dbflatproxy.h"
         "dbcheckproxy.h")
     set(DBMODEL_SOURCES
         "dbmodelmanager.cc"
         "dbmodel.cc"
         "dbmodeltbl.cc"
         "dbmodelprivate.cc"
+        "dbmodellookup.cc"
+        "dbmodelfetcher.cc"
+        "dbmodellocale.cc"
+        "dbmodelsql.cc"
+        "dbmodelstore.cc"
         "dbmodelcol.cc"
+        "dbmodelformat.cc"
+        "dbmodelrow.cc"
+        "dbmodelsortkeys.cc"
+        "dbflatproxy.cc"
         "dbcheckproxy.cc")
     set(DBMODEL_QT_MODS
         Core Sql Widgets)
@@ -13,14 +13,15 @@
 #include <dbmodel/dbmodel-config.h>
 #include <dbmodel/dbmodelcol.h>
 #include <dbmodel/dbmodeltbl.h>
+#include <dbmodel/dbflatproxy.h>
 
 #include <QSqlRecord>
-#include <QSortFilterProxyModel>
 #include <QSqlDatabase>
 #include <QVector>
 #include <QModelIndex>
 
 class DbModelPrivate;
+class DbModelSortKeys;
 
 QT_BEGIN_NAMESPACE
 class QSqlQueryModel;
@@ -29,11 +30,12 @@ class QAbstractItemView;
 QT_END_NAMESPACE
 
 //! A Qt model capable of representing sql tables.
-class DBMODEL_EXPORT DbModel : public QSortFilterProxyModel  {
+class DBMODEL_EXPORT DbModel : public DbFlatProxy  {
     Q_OBJECT
 
     DbModelPrivate * impl; /**< the private implementation */
     QString filter_; /**< current installed filter */
+    DbModelSortKeys * sort_keys_; /**< keys of the column being sorted */
 
 public:
 
@@ -99,16 +101,22 @@ public:
     virtual int
     rowCount (
             const QModelIndex & idx) const {
-        return QSortFilterProxyModel::rowCount (idx);
+        return DbFlatProxy::rowCount (idx);
     }
 
     //! Number of columns.
     virtual int
     columnCount (
             const QModelIndex & idx) const {
-        return QSortFilterProxyModel::columnCount (idx);
+        return DbFlatProxy::columnCount (idx);
     }
 
+    //! Sort the rows on a column.
+    virtual void
+    sort (
+            int column,
+            Qt::SortOrder order = Qt::AscendingOrder);
+
     //! Custom sorting.
     bool
     lessThan (
@@ -178,6 +186,20 @@ public:
     findTable (
             const QString & table) const;
 
+    //! Fill a buffer with the values of a block of cells (row by row).
+    bool
+    fetchBlock (
+            int first_row,
+            int row_count,
+            const QList<int> & columns,
+            int role,
+            QVector<QVariant> & values) const;
+
+    //! A view of a row that reads the values in place.
+    DbModelRow
+    rowView (
+            int row) const;
+
     //! Get a record for a row
     QSqlRecord
     record (
@@ -187,6 +209,74 @@ public:
     void
     reloadHeaders ();
 
+    //! Read the format settings of the columns again (the locale changed).
+    void
+    reloadFormats ();
+
+    //! Change the alignment of the values in a column (0 for default).
+    bool
+    setColumnAlignment (
+            int column,
+            Qt::Alignment value);
+
+    //! Maximum number of values kept by the cache of cell values.
+    int
+    cellCacheSize () const;
+
+    //! Change the number of values kept by the cache of cell values.
+    void
+    setCellCacheSize (
+            int value);
+
+    //! Does the model keep a typed copy of the rows?
+    bool
+    columnarStore () const;
+
+    //! Read the rows from a typed copy instead of the sql cache.
+    void
+    setColumnarStore (
+            bool b_enable);
+
+    //! How are the values for foreign columns retrieved.
+    DbModelTbl::ForeignMode
+    foreignMode () const;
+
+    //! Change the way values for foreign columns are retrieved.
+    void
+    setForeignMode (
+            DbModelTbl::ForeignMode value);
+
+    //! Change the way the rows of a secondary table are loaded.
+    bool
+    setLookupMode (
+            DbModelTbl::LookupMode value,
+            int table_index);
+
+    //! Change the way the rows of a secondary table are loaded.
+    bool
+    setLookupMode (
+            DbModelTbl::LookupMode value,
+            const QString & table);
+
+    //! Change when a secondary table is selected again.
+    bool
+    setRefreshPolicy (
+            DbModelTbl::RefreshPolicy value,
+            int table_index,
+            const QVariant & argument = QVariant ());
+
+    //! Change when a secondary table is selected again.
+    bool
+    setRefreshPolicy (
+            DbModelTbl::RefreshPolicy value,
+            const QString & table,
+            const QVariant & argument = QVariant ());
+
+    //! Select a table now, regardless of its refresh policy.
+    bool
+    refreshTable (
+            int table_index);
+
 
     //! Set the callback for a column in a table.
     bool
@@ -211,6 +301,54 @@ public:
             int table_index,
             int column_index);
 
+    //! Set the callback that computes many rows of a column at once.
+    bool
+    setBatchCallback (
+            int table_index,
+            int column_index,
+            DbColBatchKb value,
+            void * user_data = NULL);
+
+    //! Set the callback that computes many rows of a column
+    //! in main table at once.
+    bool
+    setBatchCallback (
+            int column_index,
+            DbColBatchKb value,
+            void * user_data = NULL) {
+        return setBatchCallback (0, column_index, value, user_data);
+    }
+
+    //! Get the callback that computes many rows of a column at once.
+    DbColBatchKb
+    batchCallback (
+            int table_index,
+            int column_index);
+
+    //! Set the callback that computes a column from a row view.
+    bool
+    setRowCallback (
+            int table_index,
+            int column_index,
+            DbColRowKb value,
+            void * user_data = NULL);
+
+    //! Set the callback that computes a column in main table
+    //! from a row view.
+    bool
+    setRowCallback (
+            int column_index,
+            DbColRowKb value,
+            void * user_data = NULL) {
+        return setRowCallback (0, column_index, value, user_data);
+    }
+
+    //! Get the callback that computes a column from a row view.
+    DbColRowKb
+    rowCallback (
+            int table_index,
+            int column_index);
+
     //! Get the callback for a cell.
     void *
     columnCallbackData ();
@@ -268,6 +406,18 @@ public:
             long id,
             int col_id = 0);
 
+private:
+
+    //! Forget the sort keys when the internal model changes.
+    void
+    connectSortKeys ();
+
+private slots:
+
+    //! The values changed; the sort keys must be computed again.
+    void
+    forgetSortKeys ();
+
 public: virtual void anchorVtable() const;
 };
 
@@ -24,6 +24,7 @@
 #include "dbmodel.h"
 #include "dbmodelcol.h"
 #include "dbmodelprivate.h"
+#include "dbmodellookup.h"
 
 #include <dbstruct/dbrecord.h>
 
@@ -183,6 +184,19 @@ public slots:
  * This system enables the user to present any number of columns from
  * a secondary table while using a single foreign key column in
  * main table.
+ *
+ * A composite key lists the key columns separated by commas in
+ * `foreign_key_`; the first one pairs with this column and the others
+ * with the columns in this table that have the same name, or the one
+ * given as `local=remote`. Lookups then use `t_key_` (a composite key id)
+ * and the key is the list of values in `local_keys_`; `t_primary_` is
+ * still the first key column. The id is assigned by the lookup of the
+ * secondary table from `remote_keys_` and is obtained again each time
+ * that table gets another lookup.
+ *
+ * In DbModelTbl::FM_JOIN mode the secondary table is joined by the
+ * main query and `join_col_` is the column in main sql model that
+ * holds the value to display.
  */
 
 
@@ -192,8 +206,15 @@ DbModelCol::DbModelCol() :
     table_(NULL),
     t_primary_(-1),
     t_display_(-1),
+    t_key_(-1),
+    local_keys_(),
+    remote_keys_(),
+    join_col_(-1),
+    batch_kb_(NULL),
+    row_kb_(NULL),
     label_(),
-    original_()
+    original_(),
+    formatter_()
 {
     DBMODEL_TRACE_ENTRY;
     DBMODEL_TRACE_EXIT;
@@ -207,8 +228,15 @@ DbModelCol::DbModelCol(const DbColumn & source, int user_index,
     table_(&table),
     t_primary_(-1),
     t_display_(-1),
+    t_key_(-1),
+    local_keys_(),
+    remote_keys_(),
+    join_col_(-1),
+    batch_kb_(NULL),
+    row_kb_(NULL),
     label_(),
-    original_(source)
+    original_(source),
+    formatter_()
 {
     DBMODEL_TRACE_ENTRY;
     assert(table_->isValid());
@@ -222,8 +250,15 @@ DbModelCol::DbModelCol (const DbModelCol & other) :
     table_(other.table_),
     t_primary_(other.t_primary_),
     t_display_(other.t_display_),
+    t_key_(other.t_key_),
+    local_keys_(other.local_keys_),
+    remote_keys_(other.remote_keys_),
+    join_col_(other.join_col_),
+    batch_kb_(other.batch_kb_),
+    row_kb_(other.row_kb_),
     label_(other.label_),
-    original_(other.original_)
+    original_(other.original_),
+    formatter_(other.formatter_)
 {
     DBMODEL_TRACE_ENTRY;
     if (table_ != NULL) {
@@ -240,8 +275,15 @@ DbModelCol & DbModelCol::operator= (const DbModelCol & other)
     table_ = other.table_;
     t_primary_ = other.t_primary_;
     t_display_ = other.t_display_;
+    t_key_ = other.t_key_;
+    local_keys_ = other.local_keys_;
+    remote_keys_ = other.remote_keys_;
+    join_col_ = other.join_col_;
+    batch_kb_ = other.batch_kb_;
+    row_kb_ = other.row_kb_;
     label_ = other.label_;
     original_ = other.original_;
+    formatter_ = other.formatter_;
 
     if (table_ != NULL) {
         assert(table_->isValid());
@@ -250,6 +292,16 @@ DbModelCol & DbModelCol::operator= (const DbModelCol & other)
 }
 /* ========================================================================= */
 
+/* ------------------------------------------------------------------------- */
+/**
+ * Composite keys are edited through the first key column.
+ */
+QString DbModelCol::foreignKeyName () const
+{
+    return original_.foreign_key_.section (',', 0, 0).trimmed ();
+}
+/* ========================================================================= */
+
 /* ------------------------------------------------------------------------- */
 bool DbModelCol::setTristate (
         QCheckBox *control, const QVariant & value, bool b_delegate_enh) const
@@ -299,6 +351,34 @@ DbColumn::Callback DbModelCol::columnCallback () const
 }
 /* ========================================================================= */
 
+/* ------------------------------------------------------------------------- */
+bool DbModelCol::setBatchCallback (
+        DbColBatchKb value)
+{
+    if (!original_.isDynamic ()) {
+        DBMODEL_DEBUGM("Can't set batch callback for column %d; not dynamic\n",
+                       user_index_);
+        return false;
+    }
+    batch_kb_ = value;
+    return true;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+bool DbModelCol::setRowCallback (
+        DbColRowKb value)
+{
+    if (!original_.isDynamic ()) {
+        DBMODEL_DEBUGM("Can't set row callback for column %d; not dynamic\n",
+                       user_index_);
+        return false;
+    }
+    row_kb_ = value;
+    return true;
+}
+/* ========================================================================= */
+
 /* ------------------------------------------------------------------------- */
 bool DbModelCol::setCombo (
         QComboBox *control, const QVariant & key, bool b_delegate_enh) const
@@ -317,6 +397,12 @@ bool DbModelCol::setCombo (
             break;
         }
 
+        // joined or on-demand secondary tables are only loaded when needed
+        DbModelLookup * lookup = table_->lookup ();
+        if (lookup != NULL) {
+            lookup->ensureModel ();
+        }
+
         QSqlTableModel * model = table_->sqlModel();
         bool b_found = false;
 
@@ -411,10 +497,20 @@ QVariant DbModelCol::comboInsert (
 
         // get back the id
         map = rec->toMap ();
-        result = map.value (original_.foreign_key_);
+        result = map.value (foreignKeyName ());
 
-        // re-select the model to acknoledge the new value
-        table_->sqlModel()->select();
+        // make the new row available without reading the table again
+        DbModelLookup * lookup = table_->lookup ();
+        if ((lookup != NULL) && (lookup->sqlModel () != NULL)) {
+            QSqlRecord new_rec = lookup->sqlModel ()->record ();
+            int i_max = new_rec.count ();
+            for (int i = 0; i < i_max; ++i) {
+                new_rec.setValue (i, map.value (new_rec.fieldName (i)));
+            }
+            lookup->appendRecord (new_rec);
+        } else {
+            table_->select (true);
+        }
 
         break;
     }
@@ -460,8 +556,8 @@ QVariant DbModelCol::comboResult (
         }
 
         // just save the key in main model if this is an existing value
-        QSqlRecord rec = table_->sqlModel()->record (crt_idx);
-        result = rec.value (t_primary_);
+        QSqlTableModel * combo_model = table_->sqlModel ();
+        result = combo_model->index (crt_idx, t_primary_).data (Qt::EditRole);
 
 #else
         // see if the user is able to modify the source table
@@ -485,7 +581,7 @@ QVariant DbModelCol::comboResult (
                 // we're going to insert a new record in target model
                 // then we will save that record's id
                 DbRecMap map;
-                map.insert(original_.foreign_key_, control->currentText());
+                map.insert(foreignKeyName (), control->currentText());
                 DbRecord * rec = table_->meta->createDefaultRecord ();
                 rec->retrieve (map);
                 if (!rec->save (table_->meta, top_model->database()->database())) {
@@ -497,7 +593,7 @@ QVariant DbModelCol::comboResult (
 
                 // get back the id
                 map = rec->toMap ();
-                result = map.value (original_.foreign_key_);
+                result = map.value (foreignKeyName ());
 
                 // re-select the model to acknoledge the new value
                 table_->model->select();
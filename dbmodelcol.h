@@ -24,10 +24,15 @@
 /*  INCLUDES    ------------------------------------------------------------ */
 
 #include <dbmodel/dbmodel-config.h>
+#include <dbmodel/dbmodelformat.h>
+#include <dbmodel/dbmodelrow.h>
 #include <dbstruct/dbstruct.h>
 #include <dbstruct/dbcolumn.h>
 #include <dbstruct/dbtaew.h>
 
+#include <QList>
+#include <QVector>
+
 /*  INCLUDES    ============================================================ */
 //
 //
@@ -40,11 +45,27 @@ class QComboBox;
 class QVariant;
 class QModelIndex;
 class QCheckBox;
+class QSqlRecord;
 QT_END_NAMESPACE
 
 class DbModel;
 class DbModelTbl;
 
+//! Computes the values of a dynamic column for a range of rows at once;
+//! the result must have one value for each row.
+typedef QList<QVariant> (*DbColBatchKb) (
+        const DbTaew & table,
+        const QVector<DbModelRow> & rows,
+        int role,
+        DbModel * model);
+
+//! Computes the value of a dynamic column reading the row in place.
+typedef QVariant (*DbColRowKb) (
+        const DbTaew & table,
+        const DbModelRow & row,
+        int role,
+        DbModel * model);
+
 /*  DEFINITIONS    ========================================================= */
 //
 //
@@ -75,8 +96,15 @@ public:
     const DbModelTbl * table_; /**< the table that holds information that this column shows */
     int t_primary_; /**< column index in referenced table (-1 indicates this is a local column) of the key */
     int t_display_; /**< column index in referenced table (-1 indicates this is a local column) of the display */
+    int t_key_; /**< key column used for lookups in referenced table; same as `t_primary_` or a composite key id */
+    QList<int> local_keys_; /**< real indexes in this table of the columns that make up a composite key (empty for simple keys) */
+    QList<int> remote_keys_; /**< real indexes in referenced table of the columns that make up a composite key (empty for simple keys) */
+    int join_col_; /**< column index in main sql model that holds the display value (-1 if the secondary table is not joined) */
+    DbColBatchKb batch_kb_; /**< computes the values of a dynamic column for many rows (NULL to use the callback in `original_`) */
+    DbColRowKb row_kb_; /**< computes the value of a dynamic column from a row view (NULL to use the callback in `original_`) */
     QString label_; /**< cached label for the header */
     DbColumn original_; /**< original column data*/
+    DbModelFormat formatter_; /**< converts values for the user, built from `original_` */
 
     /*  DATA    ============================================================ */
     //
@@ -111,6 +139,35 @@ public:
         return t_primary_ != -1;
     }
 
+    //! Tell if the key is made up of more than one column.
+    bool
+    isComposite () const {
+        return t_key_ < -1;
+    }
+
+    //! The name of the (first) key column in referenced table.
+    QString
+    foreignKeyName () const;
+
+    //! Read the format settings of the column (again).
+    void
+    compileFormat () {
+        formatter_.compile (original_);
+    }
+
+    //! Convert a raw value of this column for the user.
+    QVariant
+    formattedData (
+            const QVariant & value) const {
+        return formatter_.format (original_, value);
+    }
+
+    //! Tell if the display value is retrieved by main query.
+    bool
+    isJoined () const {
+        return join_col_ != -1;
+    }
+
 
     //! Set a combobox to work with this column's data.
     bool
@@ -172,6 +229,24 @@ public:
     DbColKb
     columnCallback () const;
 
+    bool
+    setBatchCallback (
+            DbColBatchKb value);
+
+    DbColBatchKb
+    batchCallback () const {
+        return batch_kb_;
+    }
+
+    bool
+    setRowCallback (
+            DbColRowKb value);
+
+    DbColRowKb
+    rowCallback () const {
+        return row_kb_;
+    }
+
 
     /*  FUNCTIONS    ======================================================= */
     //
@@ -0,0 +1,168 @@
+/* ========================================================================= */
+/* ------------------------------------------------------------------------- */
+/*!
+  file         dbmodelfetcher.cc
+  date         October 2026
+  author       agent
+
+  brief        Contains the implementation for DbModelFetcher class.
+
+*//*
+
+ ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ Please read COPYING and README files in root folder
+ ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+/* ------------------------------------------------------------------------- */
+/* ========================================================================= */
+//
+//
+//
+//
+/*  INCLUDES    ------------------------------------------------------------ */
+
+#include "dbmodelfetcher.h"
+#include "dbmodellookup.h"
+#include "dbmodelprivate.h"
+
+#include <QSqlDriver>
+#include <QSqlError>
+#include <QSqlRecord>
+#include <QThread>
+
+/*  INCLUDES    ============================================================ */
+//
+//
+//
+//
+/*  DEFINITIONS    --------------------------------------------------------- */
+
+/*  DEFINITIONS    ========================================================= */
+//
+//
+//
+//
+/*  CLASS    --------------------------------------------------------------- */
+
+/**
+ * @class DbModelFetcher
+ *
+ * Used by DbModelLookup in DbModelTbl::LM_ASYNC mode. The instance lives
+ * in a worker thread and owns a clone of the connection used by the
+ * models, opened the first time it is needed. Connections can't be
+ * shared between threads, so the models are never blocked by the queries
+ * issued here. The clone is made by the constructor, in the thread that
+ * owns the connection of the models, and handed over to the worker
+ * thread; the worker only opens it by name.
+ *
+ * The rows are sent back as lists of values (in the order of
+ * the columns in the table) because these can be queued between threads
+ * without registering new types.
+ */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Must be called in the thread that owns the `source` connection.
+ *
+ * @param source the connection used by the models
+ * @param table the table to query
+ * @param worker the thread where the queries run
+ */
+DbModelFetcher::DbModelFetcher (
+        const QSqlDatabase & source, const QString & table,
+        QThread * worker) :
+    QObject (),
+    table_(table),
+    name_()
+{
+    DBMODEL_TRACE_ENTRY;
+    name_ = QString ("dbmodel-fetcher-%1").arg (
+                reinterpret_cast<quintptr>(this), 0, 16);
+    QSqlDatabase db = QSqlDatabase::cloneDatabase (source, name_);
+    if (db.driver () != NULL) {
+        db.driver ()->moveToThread (worker);
+    }
+    moveToThread (worker);
+    DBMODEL_TRACE_EXIT;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+DbModelFetcher::~DbModelFetcher()
+{
+    DBMODEL_TRACE_ENTRY;
+    DBMODEL_TRACE_EXIT;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The `fetched()` signal is always emitted, even if the query failed,
+ * so that the keys are no longer considered pending; the keys are only
+ * known to be missing if all the queries succeeded, otherwise they
+ * are remembered as failed by the lookup.
+ *
+ * @param fields the names of the columns that hold the keys
+ * @param kcol the (real) index of the column that holds the keys
+ * @param keys the list of keys to load
+ */
+void DbModelFetcher::fetch (
+        const QStringList & fields, int kcol, const QVariantList & keys)
+{
+    DBMODEL_TRACE_ENTRY;
+    QVariantList rows;
+    bool b_complete = false;
+    for (;;) {
+        if (name_.isEmpty ()) {
+            break;
+        }
+
+        QSqlDatabase db = QSqlDatabase::database (name_, false);
+        if (!db.isOpen () && !db.open ()) {
+            DBMODEL_DEBUGM("Can't open worker connection: %s\n",
+                         TMP_A(db.lastError().text()));
+            break;
+        }
+
+        QList<QSqlRecord> records;
+        b_complete = DbModelLookup::queryKeys (
+                    db, table_, fields, keys, records);
+        foreach(const QSqlRecord & rec, records) {
+            QVariantList values;
+            int i_max = rec.count ();
+            for (int i = 0; i < i_max; ++i) {
+                values.append (rec.value (i));
+            }
+            rows.append (QVariant (values));
+        }
+        break;
+    }
+    emit fetched (kcol, keys, rows, b_complete);
+    DBMODEL_TRACE_EXIT;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void DbModelFetcher::stop ()
+{
+    DBMODEL_TRACE_ENTRY;
+    if (!name_.isEmpty ()) {
+        {
+            QSqlDatabase db = QSqlDatabase::database (name_, false);
+            db.close ();
+        }
+        QSqlDatabase::removeDatabase (name_);
+        name_.clear ();
+    }
+    DBMODEL_TRACE_EXIT;
+}
+/* ========================================================================= */
+
+/*  CLASS    =============================================================== */
+//
+//
+//
+//
+void DbModelFetcher::anchorVtable() const {}
+/* ------------------------------------------------------------------------- */
+/* ========================================================================= */
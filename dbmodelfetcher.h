@@ -0,0 +1,130 @@
+/* ========================================================================= */
+/* ------------------------------------------------------------------------- */
+/*!
+  file         dbmodelfetcher.h
+  date         October 2026
+  author       agent
+
+  brief        Contains the definition for DbModelFetcher class.
+
+*//*
+
+ ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ Please read COPYING and README files in root folder
+ ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+/* ------------------------------------------------------------------------- */
+/* ========================================================================= */
+#ifndef DBMODELFETCHER_H
+#define DBMODELFETCHER_H
+//
+//
+//
+//
+/*  INCLUDES    ------------------------------------------------------------ */
+
+#include <dbmodel/dbmodel-config.h>
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QSqlDatabase>
+
+class QThread;
+
+/*  INCLUDES    ============================================================ */
+//
+//
+//
+//
+/*  DEFINITIONS    --------------------------------------------------------- */
+
+/*  DEFINITIONS    ========================================================= */
+//
+//
+//
+//
+/*  CLASS    --------------------------------------------------------------- */
+
+//! Loads rows of a secondary table in a worker thread.
+class DbModelFetcher : public QObject {
+    Q_OBJECT
+
+    //
+    //
+    //
+    //
+    /*  DEFINITIONS    ----------------------------------------------------- */
+
+    /*  DEFINITIONS    ===================================================== */
+    //
+    //
+    //
+    //
+    /*  DATA    ------------------------------------------------------------ */
+
+    QString table_; /**< the table to query */
+    QString name_; /**< name of the connection owned by the worker */
+
+    /*  DATA    ============================================================ */
+    //
+    //
+    //
+    //
+    /*  FUNCTIONS    ------------------------------------------------------- */
+
+public:
+
+    //! Constructor; the instance is moved to the worker thread.
+    DbModelFetcher (
+            const QSqlDatabase & source,
+            const QString & table,
+            QThread * worker);
+
+    Q_DISABLE_COPY(DbModelFetcher)
+
+    //! destructor
+    virtual ~DbModelFetcher();
+
+public slots:
+
+    //! Load the rows for a list of keys.
+    void
+    fetch (
+            const QStringList & fields,
+            int kcol,
+            const QVariantList & keys);
+
+    //! Close the connection (must be called in the worker thread).
+    void
+    stop ();
+
+signals:
+
+    //! The rows for a list of keys were loaded; each row is a list of values.
+    void
+    fetched (
+            int kcol,
+            const QVariantList & keys,
+            const QVariantList & rows,
+            bool b_complete);
+
+    /*  FUNCTIONS    ======================================================= */
+    //
+    //
+    //
+    //
+public: virtual void anchorVtable() const;
+}; /* class DbModelFetcher */
+
+/*  CLASS    =============================================================== */
+//
+//
+//
+//
+
+
+#endif // DBMODELFETCHER_H
+/* ------------------------------------------------------------------------- */
+/* ========================================================================= */
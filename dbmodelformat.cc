@@ -0,0 +1,229 @@
+/* ========================================================================= */
+/* ------------------------------------------------------------------------- */
+/*!
+  file         dbmodelformat.cc
+  date         October 2026
+  author       agent
+
+  brief        Contains the implementation for DbModelFormat class.
+
+*//*
+
+ ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ Please read COPYING and README files in root folder
+ ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+/* ------------------------------------------------------------------------- */
+/* ========================================================================= */
+//
+//
+//
+//
+/*  INCLUDES    ------------------------------------------------------------ */
+
+#include "dbmodelformat.h"
+#include "dbmodelprivate.h"
+
+#include <dbstruct/dbdatatype.h>
+
+#include <QCoreApplication>
+#include <QDateTime>
+
+/*  INCLUDES    ============================================================ */
+//
+//
+//
+//
+/*  DEFINITIONS    --------------------------------------------------------- */
+
+/*  DEFINITIONS    ========================================================= */
+//
+//
+//
+//
+/*  CLASS    --------------------------------------------------------------- */
+
+/**
+ * @class DbModelFormat
+ *
+ * Each DbModelCol compiles one of these when the columns are
+ * constructed, when the labels are reloaded (which is what applications
+ * do when the language changes) and when the locale changes. The
+ * settings of the column are read once and the patterns for dates and
+ * times are resolved once, so presenting a value is reduced to a switch
+ * and one conversion.
+ *
+ * The conversions repeat the rules of DbColumn::formattedData() for the
+ * current settings of the column. Each compiled conversion is checked
+ * against that method with a sample value; if the results differ the
+ * column is left to DbColumn. Bits and tristates only have a few
+ * values, so the result of DbColumn for each value is remembered
+ * instead. Columns of other types and null values are always passed
+ * to DbColumn.
+ */
+
+/* ------------------------------------------------------------------------- */
+DbModelFormat::DbModelFormat () :
+    kind_(FK_COLUMN),
+    width_(0),
+    precision_(10),
+    nr_format_('g'),
+    fill_char_(QLatin1Char (' ')),
+    pattern_(),
+    states_()
+{
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * @param column the column that provides the settings
+ */
+void DbModelFormat::compile (const DbColumn & column)
+{
+    kind_ = FK_COLUMN;
+    width_ = column.format_.width_;
+    precision_ = column.precision_;
+    nr_format_ = column.nr_format_;
+    fill_char_ = column.fill_char_;
+    pattern_.clear ();
+    states_.clear ();
+
+    if (column.isDynamic ())
+        return;
+
+    QVariant sample;
+    switch (column.columnType ()) {
+    case DbDataType::DTY_DATE: {
+        // see [here](http://doc.qt.io/qt-5/qdatetime.html#toString)
+        pattern_ = QCoreApplication::translate ("UserTime", "yyyy-MMM-dd");
+        kind_ = FK_DATE;
+        sample = QDate (2001, 12, 31);
+        break; }
+    case DbDataType::DTY_TIME: {
+        pattern_ = QCoreApplication::translate ("UserTime", "h:mm:ss");
+        kind_ = FK_TIME;
+        sample = QTime (13, 5, 9);
+        break; }
+    case DbDataType::DTY_DATETIME: {
+        pattern_ = QCoreApplication::translate (
+                    "UserTime", "yyyy-MMM-dd h:mm:ss");
+        kind_ = FK_DATETIME;
+        sample = QDateTime (QDate (2001, 12, 31), QTime (13, 5, 9));
+        break; }
+    case DbDataType::DTY_SMALLINT:
+    case DbDataType::DTY_BIGINT:
+    case DbDataType::DTY_TINYINT:
+    case DbDataType::DTY_INTEGER: {
+        kind_ = column.original_format_.isEmpty () ? FK_RAW : FK_INTEGER;
+        sample = static_cast<qlonglong>(-12345);
+        break; }
+    case DbDataType::DTY_REAL:
+    case DbDataType::DTY_MONEY:
+    case DbDataType::DTY_SMALLMONEY:
+    case DbDataType::DTY_NUMERIC:
+    case DbDataType::DTY_NUMERICSCALE:
+    case DbDataType::DTY_FLOAT:
+    case DbDataType::DTY_DECIMALSCALE:
+    case DbDataType::DTY_DECIMAL: {
+        kind_ = column.original_format_.isEmpty () ? FK_RAW : FK_REAL;
+        sample = -1234.5678;
+        break; }
+    case DbDataType::DTY_BIT:
+    case DbDataType::DTY_TRISTATE: {
+        kind_ = FK_STATES;
+        break; }
+    default:
+        break;
+    }
+
+    // the rules must give same result as DbColumn
+    if (sample.isValid () &&
+            (format (column, sample) != column.formattedData (sample))) {
+        kind_ = FK_COLUMN;
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * @param column the column that was used to compile this instance
+ * @param value the raw value
+ * @return the value to present
+ */
+QVariant DbModelFormat::format (
+        const DbColumn & column, const QVariant & value) const
+{
+    if (kind_ == FK_RAW)
+        return value;
+    if ((kind_ == FK_COLUMN) || value.isNull ())
+        return column.formattedData (value);
+
+    switch (kind_) {
+    case FK_DATE:
+        return value.toDate ().toString (pattern_);
+    case FK_TIME:
+        return value.toTime ().toString (pattern_);
+    case FK_DATETIME:
+        return value.toDateTime ().toString (pattern_);
+    case FK_INTEGER:
+        return QString (QLatin1String ("%1")).arg (
+                    value.toLongLong (), width_, precision_, fill_char_);
+    case FK_REAL:
+        return QString (QLatin1String ("%1")).arg (
+                    value.toReal (), width_, nr_format_,
+                    precision_, fill_char_);
+    case FK_STATES:
+        return formatState (column, value);
+    default:
+        return column.formattedData (value);
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Only integer and boolean values are remembered, and only the first
+ * DBMODEL_FORMAT_STATES of them; other values are always converted
+ * by DbColumn.
+ *
+ * @param column the column that was used to compile this instance
+ * @param value the raw value (not null)
+ * @return the value to present
+ */
+QVariant DbModelFormat::formatState (
+        const DbColumn & column, const QVariant & value) const
+{
+    switch (value.userType ()) {
+    case QVariant::Bool:
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+        break;
+    default:
+        return column.formattedData (value);
+    }
+
+    QPair<int, qint64> key (value.userType (), value.toLongLong ());
+    QHash<QPair<int, qint64>, QVariant>::const_iterator iter =
+            states_.constFind (key);
+    if (iter != states_.constEnd ())
+        return iter.value ();
+
+    QVariant result = column.formattedData (value);
+    if (states_.count () < DBMODEL_FORMAT_STATES) {
+        states_.insert (key, result);
+    }
+    return result;
+}
+/* ========================================================================= */
+
+/*  CLASS    =============================================================== */
+//
+//
+//
+//
+void DbModelFormat::anchorVtable() const {}
+/* ------------------------------------------------------------------------- */
+/* ========================================================================= */
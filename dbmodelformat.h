@@ -0,0 +1,151 @@
+/* ========================================================================= */
+/* ------------------------------------------------------------------------- */
+/*!
+  file         dbmodelformat.h
+  date         October 2026
+  author       agent
+
+  brief        Contains the definition for DbModelFormat class.
+
+*//*
+
+ ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ Please read COPYING and README files in root folder
+ ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+/* ------------------------------------------------------------------------- */
+/* ========================================================================= */
+#ifndef DBMODELFORMAT_H
+#define DBMODELFORMAT_H
+//
+//
+//
+//
+/*  INCLUDES    ------------------------------------------------------------ */
+
+#include <dbmodel/dbmodel-config.h>
+#include <dbstruct/dbcolumn.h>
+
+#include <QString>
+#include <QChar>
+#include <QVariant>
+#include <QHash>
+#include <QPair>
+
+/*  INCLUDES    ============================================================ */
+//
+//
+//
+//
+/*  DEFINITIONS    --------------------------------------------------------- */
+
+//! Maximum number of results remembered by a DbModelFormat::FK_STATES column.
+#define DBMODEL_FORMAT_STATES 16
+
+/*  DEFINITIONS    ========================================================= */
+//
+//
+//
+//
+/*  CLASS    --------------------------------------------------------------- */
+
+//! Converts the values of a column for the user using settings read once.
+class DBMODEL_EXPORT DbModelFormat
+{
+    //
+    //
+    //
+    //
+    /*  DEFINITIONS    ----------------------------------------------------- */
+
+public:
+
+    //! How are the values converted.
+    enum Kind {
+        FK_COLUMN = 0, /**< use DbColumn::formattedData() */
+        FK_RAW, /**< the value is presented as it is */
+        FK_INTEGER, /**< integer with width, base and fill character */
+        FK_REAL, /**< real with width, format, precision and fill character */
+        FK_DATE, /**< date with a pattern */
+        FK_TIME, /**< time with a pattern */
+        FK_DATETIME, /**< date and time with a pattern */
+        FK_STATES /**< one of a few strings (bits and tristates),
+                       remembered for each value */
+    };
+
+    /*  DEFINITIONS    ===================================================== */
+    //
+    //
+    //
+    //
+    /*  DATA    ------------------------------------------------------------ */
+
+private:
+
+    Kind kind_; /**< how are the values converted */
+    int width_; /**< field width for numbers */
+    int precision_; /**< precision for reals, base for integers */
+    char nr_format_; /**< format for reals ('f', 'e', 'g') */
+    QChar fill_char_; /**< padding for numbers */
+    QString pattern_; /**< pattern for dates and times */
+    mutable QHash<QPair<int, qint64>, QVariant> states_; /**< result of
+                             DbColumn::formattedData() by (type, value) */
+
+    /*  DATA    ============================================================ */
+    //
+    //
+    //
+    //
+    /*  FUNCTIONS    ------------------------------------------------------- */
+
+public:
+
+    //! Default constructor defers to the column.
+    DbModelFormat ();
+
+    //! destructor
+    virtual ~DbModelFormat() {}
+
+    //! How are the values converted.
+    Kind
+    kind () const {
+        return kind_;
+    }
+
+    //! Read the settings of a column (and translate the strings).
+    void
+    compile (
+            const DbColumn & column);
+
+    //! Convert a value for the user.
+    QVariant
+    format (
+            const DbColumn & column,
+            const QVariant & value) const;
+
+private:
+
+    //! Convert a value of a FK_STATES column.
+    QVariant
+    formatState (
+            const DbColumn & column,
+            const QVariant & value) const;
+
+    /*  FUNCTIONS    ======================================================= */
+    //
+    //
+    //
+    //
+public: virtual void anchorVtable() const;
+}; /* class DbModelFormat */
+
+/*  CLASS    =============================================================== */
+//
+//
+//
+//
+
+
+#endif // DBMODELFORMAT_H
+/* ------------------------------------------------------------------------- */
+/* ========================================================================= */
@@ -0,0 +1,109 @@
+/* ========================================================================= */
+/* ------------------------------------------------------------------------- */
+/*!
+  file         dbmodellocale.cc
+  date         October 2026
+  author       agent
+
+  brief        Contains the implementation for DbModelLocaleWatcher class.
+
+*//*
+
+ ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ Please read COPYING and README files in root folder
+ ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+/* ------------------------------------------------------------------------- */
+/* ========================================================================= */
+//
+//
+//
+//
+/*  INCLUDES    ------------------------------------------------------------ */
+
+#include "dbmodellocale.h"
+#include "dbmodelprivate.h"
+
+#include <QCoreApplication>
+#include <QEvent>
+
+/*  INCLUDES    ============================================================ */
+//
+//
+//
+//
+/*  DEFINITIONS    --------------------------------------------------------- */
+
+DbModelLocaleWatcher * DbModelLocaleWatcher::uniq_ = NULL;
+
+/*  DEFINITIONS    ========================================================= */
+//
+//
+//
+//
+/*  CLASS    --------------------------------------------------------------- */
+
+/**
+ * @class DbModelLocaleWatcher
+ *
+ * The application receives QEvent::LocaleChange when the locale of
+ * the system changes; models are not widgets, so they can't receive it
+ * themselves. A single instance filters the events of the application
+ * and the models connect to its `localeChanged()` signal, so the other
+ * events cost one call no matter how many models are open.
+ *
+ * The instance is owned by the application and goes away with it.
+ */
+
+/* ------------------------------------------------------------------------- */
+DbModelLocaleWatcher * DbModelLocaleWatcher::instance ()
+{
+    if (uniq_ == NULL) {
+        QCoreApplication * app = QCoreApplication::instance ();
+        if (app != NULL) {
+            uniq_ = new DbModelLocaleWatcher (app);
+        }
+    }
+    return uniq_;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+DbModelLocaleWatcher::DbModelLocaleWatcher (QObject * app) :
+    QObject (app)
+{
+    DBMODEL_TRACE_ENTRY;
+    app->installEventFilter (this);
+    DBMODEL_TRACE_EXIT;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+DbModelLocaleWatcher::~DbModelLocaleWatcher()
+{
+    DBMODEL_TRACE_ENTRY;
+    if (uniq_ == this) {
+        uniq_ = NULL;
+    }
+    DBMODEL_TRACE_EXIT;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+bool DbModelLocaleWatcher::eventFilter (QObject * watched, QEvent * event)
+{
+    if ((event->type () == QEvent::LocaleChange) && (watched == parent ())) {
+        emit localeChanged ();
+    }
+    return QObject::eventFilter (watched, event);
+}
+/* ========================================================================= */
+
+/*  CLASS    =============================================================== */
+//
+//
+//
+//
+void DbModelLocaleWatcher::anchorVtable() const {}
+/* ------------------------------------------------------------------------- */
+/* ========================================================================= */
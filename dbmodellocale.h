@@ -0,0 +1,116 @@
+/* ========================================================================= */
+/* ------------------------------------------------------------------------- */
+/*!
+  file         dbmodellocale.h
+  date         October 2026
+  author       agent
+
+  brief        Contains the definition for DbModelLocaleWatcher class.
+
+*//*
+
+ ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ Please read COPYING and README files in root folder
+ ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+/* ------------------------------------------------------------------------- */
+/* ========================================================================= */
+#ifndef DBMODELLOCALE_H
+#define DBMODELLOCALE_H
+//
+//
+//
+//
+/*  INCLUDES    ------------------------------------------------------------ */
+
+#include <dbmodel/dbmodel-config.h>
+
+#include <QObject>
+
+class QEvent;
+
+/*  INCLUDES    ============================================================ */
+//
+//
+//
+//
+/*  DEFINITIONS    --------------------------------------------------------- */
+
+/*  DEFINITIONS    ========================================================= */
+//
+//
+//
+//
+/*  CLASS    --------------------------------------------------------------- */
+
+//! Tells all the models when the locale of the system changes.
+class DbModelLocaleWatcher : public QObject {
+    Q_OBJECT
+
+    //
+    //
+    //
+    //
+    /*  DEFINITIONS    ----------------------------------------------------- */
+
+    /*  DEFINITIONS    ===================================================== */
+    //
+    //
+    //
+    //
+    /*  DATA    ------------------------------------------------------------ */
+
+    static DbModelLocaleWatcher * uniq_; /**< The one and only instance */
+
+    /*  DATA    ============================================================ */
+    //
+    //
+    //
+    //
+    /*  FUNCTIONS    ------------------------------------------------------- */
+
+public:
+
+    //! The instance (created on first use; NULL without an application).
+    static DbModelLocaleWatcher *
+    instance ();
+
+    //! Emits `localeChanged()` for QEvent::LocaleChange.
+    bool
+    eventFilter (
+            QObject * watched,
+            QEvent * event);
+
+signals:
+
+    //! The locale of the system changed.
+    void
+    localeChanged ();
+
+protected:
+
+    //! Constructor.
+    DbModelLocaleWatcher (
+            QObject * app);
+
+    //! destructor
+    virtual ~DbModelLocaleWatcher();
+
+    /*  FUNCTIONS    ======================================================= */
+    //
+    //
+    //
+    //
+public: virtual void anchorVtable() const;
+}; /* class DbModelLocaleWatcher */
+
+/*  CLASS    =============================================================== */
+//
+//
+//
+//
+
+
+#endif // DBMODELLOCALE_H
+/* ------------------------------------------------------------------------- */
+/* ========================================================================= */
@@ -0,0 +1,1238 @@
+/* ========================================================================= */
+/* ------------------------------------------------------------------------- */
+/*!
+  file         dbmodellookup.cc
+  date         October 2026
+  author       agent
+
+  brief        Contains the implementation for DbModelLookup class.
+
+*//*
+
+ ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ Please read COPYING and README files in root folder
+ ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+/* ------------------------------------------------------------------------- */
+/* ========================================================================= */
+//
+//
+//
+//
+/*  INCLUDES    ------------------------------------------------------------ */
+
+#include "dbmodellookup.h"
+#include "dbmodelfetcher.h"
+#include "dbmodelprivate.h"
+
+#include <QSqlTableModel>
+#include <QSqlDatabase>
+#include <QSqlDriver>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStringList>
+#include <QCoreApplication>
+#include <QTimer>
+#include <QThread>
+
+/*  INCLUDES    ============================================================ */
+//
+//
+//
+//
+/*  DEFINITIONS    --------------------------------------------------------- */
+
+//! Key conversion for integer indexes.
+static inline void toKey (const QVariant & value, qint64 & key)
+{
+    key = value.toLongLong ();
+}
+
+//! Separates the values of a composite key.
+#define DBMODEL_TUPLE_SEP QChar (0x1F)
+
+//! The text used to hash a key; the values of composite keys are joined.
+static QString keyString (const QVariant & value)
+{
+    if (value.type () != QVariant::List)
+        return value.toString ();
+    QStringList parts;
+    foreach(const QVariant & part, value.toList ()) {
+        parts.append (part.toString ());
+    }
+    return parts.join (QString (DBMODEL_TUPLE_SEP));
+}
+
+//! A composite key is null if any of its values is null.
+static bool isNullKey (const QVariant & value)
+{
+    if (value.type () != QVariant::List)
+        return value.isNull ();
+    foreach(const QVariant & part, value.toList ()) {
+        if (part.isNull ())
+            return true;
+    }
+    return false;
+}
+
+//! Key conversion for generic indexes.
+static inline void toKey (const QVariant & value, QString & key)
+{
+    key = keyString (value);
+}
+
+//! Key conversion for searches in integer indexes; false if not an integer.
+static bool toIntegerKey (const QVariant & value, qint64 & key)
+{
+    bool b_ok = false;
+    key = value.toLongLong (&b_ok);
+    if (b_ok && (value.type () == QVariant::Double)) {
+        b_ok = static_cast<double>(key) == value.toDouble ();
+    }
+    return b_ok;
+}
+
+/*  DEFINITIONS    ========================================================= */
+//
+//
+//
+//
+/*  CLASS    --------------------------------------------------------------- */
+
+/**
+ * @class DbModelLookup
+ *
+ * Secondary tables (the ones referenced by foreign keys) are loaded
+ * once for all the models that use them. The instances are
+ * created and reference-counted by DbModelManager, that keeps them
+ * in a registry keyed by database connection and table name.
+ *
+ * A shared lookup that was selected in current pass of the event loop is
+ * not selected again, so a number of models that are created and selected
+ * together only trigger one query for each distinct secondary table.
+ *
+ * The instance also holds the key indexes used to resolve foreign keys,
+ * so these are also built only once. Columns that hold integers
+ * (`setIntegerKey()`) are indexed by `qint64`; any other column is
+ * indexed by the string representation of its values.
+ *
+ * In DbModelTbl::LM_ONDEMAND mode the table starts empty and selecting it
+ * only discards the rows loaded so far. The rows are loaded in batches
+ * by `fetch()` (`WHERE key IN (...)`) as the keys are needed by the
+ * models. The underlying model is only selected (in full) if a combo
+ * box needs it (`ensureModel()`).
+ *
+ * The indexes follow the changes in the underlying model: inserted,
+ * removed and changed rows only update the affected keys instead of
+ * discarding the index. Rows saved to the database by other means
+ * (a new choice in a combo box) are made available with
+ * `appendRecord()`, so there is no need to read the table again; the
+ * model itself is only selected again when a combo box needs it.
+ * Keys are expected to be unique.
+ *
+ * A composite key (more than one column in secondary table) is identified
+ * by a negative id obtained from `tupleKey()` that is used in place of the
+ * key column. The key itself is a list of values (`QVariantList`) that
+ * is hashed as a single string, so searching a composite key costs the
+ * same as searching a generic one.
+ *
+ * DbModelTbl::LM_ASYNC mode works like on-demand mode but the queries
+ * run in a worker thread (see DbModelFetcher). The keys are queued with
+ * `request()` and are pending until the rows arrive; then the
+ * `rowsFetched()` signal is emitted.
+ *
+ * Any change in the rows or values available for lookups, whoever
+ * caused it, is reported by the `changed()` signal, so that all the
+ * models that share the instance can forget the values they cached.
+ *
+ * By default the rows are selected each time a model that uses the table
+ * is selected (DbModelTbl::RP_ALWAYS). Tables that rarely change may
+ * be selected only after some time (RP_TTL), only when a query
+ * reports a new version (RP_VERSION) or only when asked to (RP_MANUAL).
+ * A forced `select()` ignores the policy.
+ */
+
+/* ------------------------------------------------------------------------- */
+DbModelLookup::DbModelLookup (
+        const QString & key, QSqlTableModel * model,
+        DbModelTbl::LookupMode mode) :
+    QObject (),
+    key_(key),
+    model_(model),
+    mode_(mode),
+    fetched_(),
+    appended_(),
+    ref_count_(0),
+    loaded_(false),
+    fresh_(false),
+    stale_(false),
+    key_index_(),
+    int_index_(),
+    int_keys_(),
+    generation_(0),
+    missing_generation_(0),
+    thread_(NULL),
+    fetcher_(NULL),
+    pending_(),
+    failed_(),
+    policy_(DbModelTbl::RP_ALWAYS),
+    ttl_(0),
+    version_query_(),
+    version_(),
+    selected_()
+{
+    DBMODEL_TRACE_ENTRY;
+    selected_.invalidate ();
+    if (model_ != NULL) {
+        connect (model_, SIGNAL(modelReset()),
+                 this, SLOT(modelWasReset()));
+        connect (model_, SIGNAL(layoutChanged()),
+                 this, SLOT(modelWasReset()));
+        connect (model_, SIGNAL(rowsInserted(QModelIndex,int,int)),
+                 this, SLOT(rowsWereInserted(QModelIndex,int,int)));
+        connect (model_, SIGNAL(rowsRemoved(QModelIndex,int,int)),
+                 this, SLOT(rowsWereRemoved(QModelIndex,int,int)));
+        connect (model_, SIGNAL(dataChanged(QModelIndex,QModelIndex)),
+                 this, SLOT(dataWasChanged(QModelIndex,QModelIndex)));
+    }
+    DBMODEL_TRACE_EXIT;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+DbModelLookup::~DbModelLookup()
+{
+    DBMODEL_TRACE_ENTRY;
+    if (thread_ != NULL) {
+        QMetaObject::invokeMethod (
+                    fetcher_, "stop", Qt::BlockingQueuedConnection);
+        thread_->quit ();
+        thread_->wait ();
+        delete fetcher_;
+        fetcher_ = NULL;
+        delete thread_;
+        thread_ = NULL;
+    }
+    if (model_ != NULL) {
+        model_->disconnect (this);
+        model_->deleteLater ();
+        model_ = NULL;
+    }
+    DBMODEL_TRACE_EXIT;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * @param b_force select the model even if this was already done in
+ * current pass of the event loop or if the refresh policy says it is
+ * not stale
+ * @return false if the model is not valid or the select failed
+ */
+bool DbModelLookup::select (bool b_force)
+{
+    DBMODEL_TRACE_ENTRY;
+    bool b_ret = false;
+    for (;;) {
+        if (model_ == NULL) {
+            break;
+        }
+
+        if (fresh_ && !b_force) {
+            b_ret = true;
+            break;
+        }
+
+        QVariant version;
+        bool b_stale = isStale (version);
+        if (!b_stale && !b_force) {
+            b_ret = true;
+            break;
+        }
+
+        if (isOnDemand ()) {
+            // rows are fetched again as they are needed; the answers
+            // to requests already sent are still accepted
+            fetched_.clear ();
+            pending_.clear ();
+            b_ret = loaded_ ? model_->select () : true;
+        } else {
+            b_ret = model_->select ();
+        }
+        failed_.clear ();
+        clearKeyIndex ();
+        if (!b_ret) {
+            DBMODEL_DEBUGM("model->select failed: %s\n",
+                         TMP_A(model_->lastError().text()));
+            DBMODEL_DEBUGM("    query: %s\n",
+                         TMP_A(model_->query().lastQuery()));
+            selected_.invalidate ();
+            break;
+        }
+        selected_.start ();
+        version_ = version;
+        if (isOnDemand ()) {
+            emit changed ();
+        }
+#       ifdef DBMODEL_DEBUG
+        DBMODEL_DEBUGM("        model->select query: %s\n",
+                     TMP_A(model_->query().lastQuery()));
+#       endif
+
+        loaded_ = loaded_ || !isOnDemand ();
+        if (isShared () && !fresh_ && (QCoreApplication::instance () != NULL)) {
+            fresh_ = true;
+            QTimer::singleShot (0, this, SLOT(expireFresh()));
+        }
+        break;
+    }
+    DBMODEL_TRACE_EXIT;
+    return b_ret;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * @return the number of milliseconds for RP_TTL, the statement for
+ * RP_VERSION and an invalid value for other policies
+ */
+QVariant DbModelLookup::refreshArgument () const
+{
+    switch (policy_) {
+    case DbModelTbl::RP_TTL:
+        return ttl_;
+    case DbModelTbl::RP_VERSION:
+        return version_query_;
+    default:
+        return QVariant ();
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * @param value the new policy
+ * @param argument the number of milliseconds for RP_TTL; the statement
+ * that retrieves the version (a single value) for RP_VERSION
+ * @return false if the argument is not valid for the policy
+ */
+bool DbModelLookup::setRefreshPolicy (
+        DbModelTbl::RefreshPolicy value, const QVariant & argument)
+{
+    bool b_ret = false;
+    for (;;) {
+        if (value == DbModelTbl::RP_TTL) {
+            bool b_ok;
+            int ttl = argument.toInt (&b_ok);
+            if (!b_ok || (ttl < 0)) {
+                DBMODEL_DEBUGM("Invalid time to live for %s\n",
+                               TMP_A(key_));
+                break;
+            }
+            ttl_ = ttl;
+        } else if (value == DbModelTbl::RP_VERSION) {
+            QString statement = argument.toString ();
+            if (statement.isEmpty ()) {
+                DBMODEL_DEBUGM("The version policy needs a statement\n");
+                break;
+            }
+            version_query_ = statement;
+            version_ = QVariant ();
+        }
+
+        policy_ = value;
+        b_ret = true;
+        break;
+    }
+    return b_ret;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * A model that was never selected is always stale. For RP_VERSION the
+ * statement is executed each time; a failed statement makes the model
+ * stale.
+ *
+ * @param version receives current version for RP_VERSION
+ * @return true if the model should be selected again
+ */
+bool DbModelLookup::isStale (QVariant & version) const
+{
+    if ((policy_ == DbModelTbl::RP_VERSION) && (model_ != NULL)) {
+        QSqlQuery query (model_->database ());
+        query.setForwardOnly (true);
+        if (query.exec (version_query_) && query.next ()) {
+            version = query.value (0);
+        } else {
+            DBMODEL_DEBUGM("version query failed: %s\n",
+                         TMP_A(query.lastError().text()));
+        }
+    }
+
+    if (!selected_.isValid ())
+        return true;
+
+    switch (policy_) {
+    case DbModelTbl::RP_TTL:
+        return selected_.elapsed () >= ttl_;
+    case DbModelTbl::RP_VERSION:
+        return !version.isValid () || (version != version_);
+    case DbModelTbl::RP_MANUAL:
+        return false;
+    default:
+        return true;
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The index for a key column is created the first time that column is
+ * searched and it is discarded by `clearKeyIndex()` each time the
+ * underlying model is selected again. If the model fetched more rows
+ * since the index was built only the new rows are added.
+ *
+ * If same key is present in more than one row the first one is reported.
+ * Integer key columns only match values that are integers.
+ *
+ * @param kcol the (real) index of the column that holds the keys
+ * @param key the value to search for
+ * @return the index of the row or -1 if the key was not found
+ */
+int DbModelLookup::findRow (int kcol, const QVariant &key) const
+{
+    if ((model_ == NULL) || isNullKey (key))
+        return -1;
+
+    if (int_keys_.contains (kcol)) {
+        qint64 i_key;
+        if (!toIntegerKey (key, i_key))
+            return -1;
+        return findRowIn (int_index_[kcol], kcol, i_key);
+    } else {
+        return findRowIn (key_index_[kcol], kcol, keyString (key));
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+template <typename K>
+int DbModelLookup::findRowIn (
+        KeyIndex<K> & kidx, int kcol, const K & key) const
+{
+    int i_max = rowCount ();
+    if (kidx.indexed_ == 0) {
+        kidx.rows_.reserve (i_max);
+    } else if (kidx.indexed_ < i_max) {
+        // keys that were missing may be present in new rows
+        ++missing_generation_;
+    }
+    if (kidx.indexed_ < i_max) {
+        indexRows (kidx, kcol, kidx.indexed_, i_max - 1);
+        kidx.indexed_ = i_max;
+    }
+
+    return kidx.rows_.value (key, -1);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * If same key is present in more than one row the first one is kept.
+ */
+template <typename K>
+void DbModelLookup::indexRows (
+        KeyIndex<K> & kidx, int kcol, int first, int last) const
+{
+    K iter_key;
+    for (int i = first; i <= last; ++i) {
+        QVariant iter_value = keyValue (i, kcol);
+        if (isNullKey (iter_value))
+            continue;
+        toKey (iter_value, iter_key);
+        int prev = kidx.rows_.value (iter_key, -1);
+        if ((prev == -1) || (prev > i)) {
+            kidx.rows_.insert (iter_key, i);
+        }
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Rows past the indexed ones are left for `findRowIn()`.
+ *
+ * @param kidx the index to update
+ * @param kcol the (real) index of the column that holds the keys
+ * @param first the first row that was inserted or removed
+ * @param delta number of rows inserted (positive) or removed (negative)
+ */
+template <typename K>
+void DbModelLookup::shiftRows (
+        KeyIndex<K> & kidx, int kcol, int first, int delta) const
+{
+    if (kidx.indexed_ <= first)
+        return;
+
+    int removed_end = first - delta;
+    typename QHash<K, int>::iterator iter = kidx.rows_.begin ();
+    while (iter != kidx.rows_.end ()) {
+        int row = iter.value ();
+        if (row < first) {
+            ++iter;
+        } else if ((delta < 0) && (row < removed_end)) {
+            iter = kidx.rows_.erase (iter);
+        } else {
+            iter.value () = row + delta;
+            ++iter;
+        }
+    }
+
+    if (delta > 0) {
+        kidx.indexed_ += delta;
+        indexRows (kidx, kcol, first, first + delta - 1);
+    } else if (kidx.indexed_ > removed_end) {
+        kidx.indexed_ += delta;
+    } else {
+        kidx.indexed_ = first;
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * @param kidx the index to update
+ * @param kcol the (real) index of the column that holds the keys
+ * @param first the first row that changed
+ * @param last the last row that changed
+ */
+template <typename K>
+void DbModelLookup::updateRows (
+        KeyIndex<K> & kidx, int kcol, int first, int last) const
+{
+    last = qMin (last, kidx.indexed_ - 1);
+    if (last < first)
+        return;
+
+    typename QHash<K, int>::iterator iter = kidx.rows_.begin ();
+    while (iter != kidx.rows_.end ()) {
+        int row = iter.value ();
+        if ((row >= first) && (row <= last)) {
+            iter = kidx.rows_.erase (iter);
+        } else {
+            ++iter;
+        }
+    }
+    indexRows (kidx, kcol, first, last);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Integer keys are hashed directly instead of being converted to
+ * strings first, which is the most common case for foreign keys.
+ *
+ * @param kcol the (real) index of the column that holds the keys
+ */
+void DbModelLookup::setIntegerKey (int kcol)
+{
+    if (!int_keys_.contains (kcol)) {
+        int_keys_.insert (kcol);
+        key_index_.remove (kcol);
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The row is placed after the rows of the model and is found by
+ * `findRow()` like any other row. Only this row is indexed, the next
+ * time one of its keys is searched.
+ *
+ * The model itself does not have the row, so it is selected again
+ * next time a combo box needs it (`ensureModel()`).
+ *
+ * @param rec the values in the new row, in the order of the columns
+ * in the table
+ */
+void DbModelLookup::appendRecord (const QSqlRecord & rec)
+{
+    if (model_ == NULL)
+        return;
+
+    if (isOnDemand ()) {
+        fetched_.append (rec);
+    } else {
+        appended_.append (rec);
+    }
+    stale_ = true;
+
+    // the key may have been searched before
+    QHash<int, KeyIndex<qint64> >::iterator i_iter;
+    for (i_iter = int_index_.begin (); i_iter != int_index_.end (); ++i_iter) {
+        i_iter.value ().missing_.remove (rec.value (i_iter.key ()).toLongLong ());
+    }
+    QHash<int, KeyIndex<QString> >::iterator s_iter;
+    for (s_iter = key_index_.begin (); s_iter != key_index_.end (); ++s_iter) {
+        s_iter.value ().missing_.remove (
+                    keyString (keyValue (rec, s_iter.key ())));
+    }
+    ++missing_generation_;
+    emit changed ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * In full mode this is the same as selecting the model if that was
+ * not done already. In on-demand mode the rows used for lookups are
+ * not affected.
+ *
+ * The model is also selected if rows were added with `appendRecord()`.
+ *
+ * @return false if the model is not valid or the select failed
+ */
+bool DbModelLookup::ensureModel ()
+{
+    if (model_ == NULL)
+        return false;
+    if (loaded_ && !stale_)
+        return true;
+
+    bool b_ret = model_->select ();
+    if (b_ret) {
+        loaded_ = true;
+        if (!isOnDemand ()) {
+            clearKeyIndex ();
+        }
+    } else {
+        DBMODEL_DEBUGM("model->select failed: %s\n",
+                     TMP_A(model_->lastError().text()));
+    }
+    return b_ret;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * @return number of rows in the model (full mode) or number of rows
+ * fetched so far (on-demand mode)
+ */
+int DbModelLookup::rowCount () const
+{
+    if (isOnDemand ())
+        return fetched_.count ();
+    if (model_ == NULL)
+        return 0;
+    return model_->rowCount () + appended_.count ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+QVariant DbModelLookup::value (int row, int col) const
+{
+    if ((row < 0) || (row >= rowCount ()))
+        return QVariant ();
+    if (isOnDemand ())
+        return fetched_.at (row).value (col);
+    int model_rows = model_->rowCount ();
+    if (row >= model_rows)
+        return appended_.at (row - model_rows).value (col);
+    return model_->index (row, col).data (Qt::EditRole);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+QSqlRecord DbModelLookup::record (int row) const
+{
+    if ((row < 0) || (row >= rowCount ()))
+        return QSqlRecord ();
+    if (isOnDemand ())
+        return fetched_.at (row);
+    int model_rows = model_->rowCount ();
+    if (row >= model_rows)
+        return appended_.at (row - model_rows);
+    return model_->record (row);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * In full mode all keys are known. A null key is always known and so
+ * is a key whose query failed, until next `select()`.
+ *
+ * @param kcol the (real) index of the column that holds the keys
+ * @param key the value to search for
+ * @return false if the key should be fetched
+ */
+bool DbModelLookup::isKnown (int kcol, const QVariant &key) const
+{
+    if (!isOnDemand () || isNullKey (key))
+        return true;
+    if (findRow (kcol, key) != -1)
+        return true;
+    if (failed_.value (kcol).contains (keyString (key)))
+        return true;
+    if (int_keys_.contains (kcol)) {
+        // a value that is not an integer can't be found
+        qint64 i_key;
+        if (!toIntegerKey (key, i_key))
+            return true;
+        return int_index_[kcol].missing_.contains (i_key);
+    } else {
+        return key_index_[kcol].missing_.contains (keyString (key));
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Keys that are already known are skipped. The rest are loaded
+ * with `queryKeys()`. Keys that are not found in the database are
+ * remembered so they are not queried again until next `select()`;
+ * if a query fails the keys are remembered as failed, also until next
+ * `select()`, so a broken connection does not run the query again
+ * each time the keys are needed.
+ *
+ * @param kcol the (real) index of the column that holds the keys
+ * @param keys the list of keys to load
+ * @return the number of rows that were loaded
+ */
+int DbModelLookup::fetch (int kcol, const QList<QVariant> & keys)
+{
+    DBMODEL_TRACE_ENTRY;
+    int result = 0;
+    for (;;) {
+        if (!isOnDemand () || (model_ == NULL)) {
+            break;
+        }
+
+        // only fetch each unknown key once
+        QList<QVariant> pending;
+        QSet<QString> seen;
+        foreach(const QVariant & key, keys) {
+            if (isKnown (kcol, key))
+                continue;
+            QString s_key = keyString (key);
+            if (seen.contains (s_key))
+                continue;
+            seen.insert (s_key);
+            pending.append (key);
+        }
+        if (pending.isEmpty ()) {
+            break;
+        }
+
+        QStringList fields = keyFields (kcol);
+        if (fields.isEmpty ()) {
+            DBMODEL_DEBUGM("Column %d is not a valid key for %s\n",
+                           kcol, TMP_A(model_->tableName ()));
+            break;
+        }
+
+        QList<QSqlRecord> rows;
+        bool b_complete = queryKeys (
+                    model_->database (), model_->tableName (),
+                    fields, pending, rows);
+        result = rows.count ();
+        if (result > 0) {
+            fetched_.append (rows);
+            ++missing_generation_;
+        }
+        if (b_complete) {
+            markMissing (kcol, pending);
+        } else {
+            markFailed (kcol, pending);
+        }
+        if (result > 0) {
+            emit changed ();
+        }
+        break;
+    }
+    DBMODEL_TRACE_EXIT;
+    return result;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Keys that are either known or pending are skipped. The rest are sent
+ * to the worker thread, that is started the first time it is needed;
+ * the connection used by the worker is cloned here, in the thread
+ * that owns the connection of the models.
+ *
+ * @param kcol the (real) index of the column that holds the keys
+ * @param keys the list of keys to load
+ * @return the number of keys that were queued
+ */
+int DbModelLookup::request (int kcol, const QList<QVariant> & keys)
+{
+    DBMODEL_TRACE_ENTRY;
+    int result = 0;
+    for (;;) {
+        if (!isAsync () || (model_ == NULL)) {
+            break;
+        }
+
+        QStringList fields = keyFields (kcol);
+        if (fields.isEmpty ()) {
+            DBMODEL_DEBUGM("Column %d is not a valid key for %s\n",
+                           kcol, TMP_A(model_->tableName ()));
+            break;
+        }
+
+        QSet<QString> & in_flight = pending_[kcol];
+        QVariantList pending;
+        foreach(const QVariant & key, keys) {
+            if (isKnown (kcol, key))
+                continue;
+            QString s_key = keyString (key);
+            if (in_flight.contains (s_key))
+                continue;
+            in_flight.insert (s_key);
+            pending.append (key);
+        }
+        if (pending.isEmpty ()) {
+            break;
+        }
+
+        if (thread_ == NULL) {
+            thread_ = new QThread ();
+            fetcher_ = new DbModelFetcher (
+                        model_->database (), model_->tableName (), thread_);
+            connect (fetcher_, SIGNAL(fetched(int,QVariantList,QVariantList,bool)),
+                     this, SLOT(keysFetched(int,QVariantList,QVariantList,bool)));
+            thread_->start ();
+        }
+
+        QMetaObject::invokeMethod (
+                    fetcher_, "fetch", Qt::QueuedConnection,
+                    Q_ARG(QStringList, fields),
+                    Q_ARG(int, kcol),
+                    Q_ARG(QVariantList, pending));
+        result = pending.count ();
+        break;
+    }
+    DBMODEL_TRACE_EXIT;
+    return result;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The keys are loaded with queries of the form
+ * `SELECT * FROM table WHERE key IN (...)`, each one with at most
+ * DBMODEL_ONDEMAND_BATCH keys. Composite keys use
+ * `WHERE (k1 = ? AND k2 = ?) OR ...` and each key in the list
+ * is a list of values, one for each column.
+ *
+ * This only uses the connection that it receives, so it may be called
+ * from any thread that owns that connection.
+ *
+ * @param db the connection to use
+ * @param table the name of the table
+ * @param fields the names of the columns that hold the keys
+ * @param keys the list of keys to load
+ * @param rows the rows that were found are appended here
+ * @return false if a query failed
+ */
+bool DbModelLookup::queryKeys (
+        const QSqlDatabase & db, const QString & table,
+        const QStringList & fields, const QList<QVariant> & keys,
+        QList<QSqlRecord> & rows)
+{
+    DBMODEL_TRACE_ENTRY;
+    bool b_ret = true;
+    QSqlDriver * driver = db.driver ();
+    QStringList names;
+    foreach(const QString & field, fields) {
+        names.append (driver->escapeIdentifier (field, QSqlDriver::FieldName));
+    }
+    QString s_table = driver->escapeIdentifier (table, QSqlDriver::TableName);
+
+    // each key adds a mark to the statement
+    bool b_tuple = names.count () > 1;
+    QString statement;
+    QString mark;
+    QString separator;
+    if (b_tuple) {
+        statement = QString ("SELECT * FROM %1 WHERE %2").arg (s_table);
+        mark = QString ("(%1 = ?)").arg (names.join (" = ? AND "));
+        separator = " OR ";
+    } else {
+        statement = QString ("SELECT * FROM %1 WHERE %2 IN (%3)")
+                .arg (s_table).arg (names.value (0));
+        mark = "?";
+        separator = ", ";
+    }
+    int batch = qMax (1, DBMODEL_ONDEMAND_BATCH / qMax (1, names.count ()));
+
+    int i_max = keys.count ();
+    for (int start = 0; start < i_max; start += batch) {
+        int count = qMin (batch, i_max - start);
+        QStringList marks;
+        for (int i = 0; i < count; ++i) {
+            marks.append (mark);
+        }
+
+        QSqlQuery query (db);
+        query.setForwardOnly (true);
+        query.prepare (statement.arg (marks.join (separator)));
+        for (int i = 0; i < count; ++i) {
+            if (b_tuple) {
+                foreach(const QVariant & part, keys.at (start + i).toList ()) {
+                    query.addBindValue (part);
+                }
+            } else {
+                query.addBindValue (keys.at (start + i));
+            }
+        }
+        if (!query.exec ()) {
+            DBMODEL_DEBUGM("fetch failed: %s\n",
+                         TMP_A(query.lastError().text()));
+            DBMODEL_DEBUGM("    query: %s\n",
+                         TMP_A(query.lastQuery()));
+            b_ret = false;
+            break;
+        }
+        while (query.next ()) {
+            rows.append (query.record ());
+        }
+    }
+    DBMODEL_TRACE_EXIT;
+    return b_ret;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * @param kcol the (real) index of the column that holds the keys
+ * @param keys the keys that were searched
+ * @return the number of keys that were not already known to be missing
+ */
+int DbModelLookup::markMissing (int kcol, const QList<QVariant> & keys)
+{
+    int result = 0;
+    foreach(const QVariant & key, keys) {
+        if (findRow (kcol, key) != -1)
+            continue;
+        if (int_keys_.contains (kcol)) {
+            QSet<qint64> & missing = int_index_[kcol].missing_;
+            qint64 i_key;
+            if (!toIntegerKey (key, i_key))
+                continue;
+            if (!missing.contains (i_key)) {
+                missing.insert (i_key);
+                ++result;
+            }
+        } else {
+            QSet<QString> & missing = key_index_[kcol].missing_;
+            QString s_key = keyString (key);
+            if (!missing.contains (s_key)) {
+                missing.insert (s_key);
+                ++result;
+            }
+        }
+    }
+    return result;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The keys are not queried again until next `select()`.
+ *
+ * @param kcol the (real) index of the column that holds the keys
+ * @param keys the keys that were searched
+ * @return the number of keys that were not already known to have failed
+ */
+int DbModelLookup::markFailed (int kcol, const QList<QVariant> & keys)
+{
+    int result = 0;
+    QSet<QString> & failed = failed_[kcol];
+    foreach(const QVariant & key, keys) {
+        if (findRow (kcol, key) != -1)
+            continue;
+        QString s_key = keyString (key);
+        if (!failed.contains (s_key)) {
+            failed.insert (s_key);
+            ++result;
+        }
+    }
+    return result;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+bool DbModelLookup::isPending (int kcol, const QVariant &key) const
+{
+    return pending_.value (kcol).contains (keyString (key));
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Same list of columns always gets same id.
+ *
+ * @param kcols the (real) indexes of the columns that make up the key,
+ * in the order used by the keys
+ * @return the id to use in place of the key column (always less than -1)
+ */
+int DbModelLookup::tupleKey (const QList<int> & kcols)
+{
+    QHash<int, QList<int> >::const_iterator iter;
+    for (iter = tuples_.constBegin (); iter != tuples_.constEnd (); ++iter) {
+        if (iter.value () == kcols)
+            return iter.key ();
+    }
+    int result = -2 - tuples_.count ();
+    tuples_.insert (result, kcols);
+    return result;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+QVariant DbModelLookup::keyValue (int row, int kcol) const
+{
+    if (!isTupleKey (kcol))
+        return value (row, kcol);
+
+    QVariantList result;
+    foreach(int col, tuples_.value (kcol)) {
+        result.append (value (row, col));
+    }
+    return result;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+QVariant DbModelLookup::keyValue (const QSqlRecord & rec, int kcol) const
+{
+    if (!isTupleKey (kcol))
+        return rec.value (kcol);
+
+    QVariantList result;
+    foreach(int col, tuples_.value (kcol)) {
+        result.append (rec.value (col));
+    }
+    return result;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * @param kcol the (real) index of the key column or a composite key id
+ * @return an empty list if any of the columns is not valid
+ */
+QStringList DbModelLookup::keyFields (int kcol) const
+{
+    QStringList result;
+    if (model_ == NULL)
+        return result;
+
+    QList<int> kcols;
+    if (isTupleKey (kcol)) {
+        kcols = tuples_.value (kcol);
+    } else {
+        kcols.append (kcol);
+    }
+
+    QSqlRecord fields = model_->record ();
+    foreach(int col, kcols) {
+        if ((col < 0) || (col >= fields.count ()))
+            return QStringList ();
+        result.append (fields.fieldName (col));
+    }
+    return result;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+bool DbModelLookup::isKeyInRange (int kcol, int left, int right) const
+{
+    if (!isTupleKey (kcol))
+        return (kcol >= left) && (kcol <= right);
+
+    foreach(int col, tuples_.value (kcol)) {
+        if ((col >= left) && (col <= right))
+            return true;
+    }
+    return false;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void DbModelLookup::expireFresh ()
+{
+    fresh_ = false;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The rows are converted back to records using the structure of the
+ * table.
+ *
+ * @param kcol the (real) index of the column that holds the keys
+ * @param keys the keys that were requested
+ * @param rows the rows that were found; each one is a list of values
+ * @param b_complete false if a query failed (the keys that were not
+ * found may still exist)
+ *
+ * `rowsFetched()` is only emitted if rows arrived or some keys are now
+ * known to be missing or failed, so that the models show the final
+ * values in place of the placeholders; a failed query is not
+ * repeated until next `select()`.
+ */
+void DbModelLookup::keysFetched (
+        int kcol, const QVariantList & keys, const QVariantList & rows,
+        bool b_complete)
+{
+    DBMODEL_TRACE_ENTRY;
+    QSet<QString> & in_flight = pending_[kcol];
+    foreach(const QVariant & key, keys) {
+        in_flight.remove (keyString (key));
+    }
+
+    if (!rows.isEmpty () && (model_ != NULL)) {
+        QSqlRecord structure = model_->record ();
+        foreach(const QVariant & row, rows) {
+            QVariantList values = row.toList ();
+            QSqlRecord rec = structure;
+            int i_max = qMin (rec.count (), values.count ());
+            for (int i = 0; i < i_max; ++i) {
+                rec.setValue (i, values.at (i));
+            }
+            fetched_.append (rec);
+        }
+        ++missing_generation_;
+    }
+    int settled;
+    if (b_complete) {
+        settled = markMissing (kcol, keys);
+    } else {
+        settled = markFailed (kcol, keys);
+    }
+
+    if (!rows.isEmpty ()) {
+        emit changed ();
+    }
+    if (!rows.isEmpty () || (settled > 0)) {
+        emit rowsFetched ();
+    }
+    DBMODEL_TRACE_EXIT;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The model now has all the rows in the database, including the ones
+ * added with `appendRecord()`.
+ */
+void DbModelLookup::modelWasReset ()
+{
+    stale_ = false;
+    if (isOnDemand ())
+        return;
+    appended_.clear ();
+    clearKeyIndex ();
+    emit changed ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Rows fetched by the model at the end (QSqlTableModel loads large
+ * tables in chunks) don't change the row of any indexed key. The
+ * index is only updated when rows are inserted among indexed rows.
+ */
+void DbModelLookup::rowsWereInserted (
+        const QModelIndex & parent, int first, int last)
+{
+    if (isOnDemand () || parent.isValid ())
+        return;
+
+    int delta = last - first + 1;
+    QHash<int, KeyIndex<qint64> >::iterator i_iter;
+    for (i_iter = int_index_.begin (); i_iter != int_index_.end (); ++i_iter) {
+        shiftRows (i_iter.value (), i_iter.key (), first, delta);
+    }
+    QHash<int, KeyIndex<QString> >::iterator s_iter;
+    for (s_iter = key_index_.begin (); s_iter != key_index_.end (); ++s_iter) {
+        shiftRows (s_iter.value (), s_iter.key (), first, delta);
+    }
+    ++generation_;
+    emit changed ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void DbModelLookup::rowsWereRemoved (
+        const QModelIndex & parent, int first, int last)
+{
+    if (isOnDemand () || parent.isValid ())
+        return;
+
+    int delta = first - last - 1;
+    QHash<int, KeyIndex<qint64> >::iterator i_iter;
+    for (i_iter = int_index_.begin (); i_iter != int_index_.end (); ++i_iter) {
+        shiftRows (i_iter.value (), i_iter.key (), first, delta);
+    }
+    QHash<int, KeyIndex<QString> >::iterator s_iter;
+    for (s_iter = key_index_.begin (); s_iter != key_index_.end (); ++s_iter) {
+        shiftRows (s_iter.value (), s_iter.key (), first, delta);
+    }
+    ++generation_;
+    emit changed ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Only the indexes of the columns in the range are updated. The rows
+ * that hold other keys are not affected.
+ */
+void DbModelLookup::dataWasChanged (
+        const QModelIndex & top_left, const QModelIndex & bottom_right)
+{
+    if (isOnDemand () || top_left.parent ().isValid ())
+        return;
+
+    int first = top_left.row ();
+    int last = bottom_right.row ();
+    int left = top_left.column ();
+    int right = bottom_right.column ();
+    bool b_changed = false;
+
+    QHash<int, KeyIndex<qint64> >::iterator i_iter;
+    for (i_iter = int_index_.begin (); i_iter != int_index_.end (); ++i_iter) {
+        if ((i_iter.key () < left) || (i_iter.key () > right))
+            continue;
+        updateRows (i_iter.value (), i_iter.key (), first, last);
+        b_changed = true;
+    }
+    QHash<int, KeyIndex<QString> >::iterator s_iter;
+    for (s_iter = key_index_.begin (); s_iter != key_index_.end (); ++s_iter) {
+        if (!isKeyInRange (s_iter.key (), left, right))
+            continue;
+        updateRows (s_iter.value (), s_iter.key (), first, last);
+        b_changed = true;
+    }
+
+    // the rows resolved for changed keys are no longer valid
+    if (b_changed) {
+        ++generation_;
+    }
+    emit changed ();
+}
+/* ========================================================================= */
+
+/*  CLASS    =============================================================== */
+//
+//
+//
+//
+void DbModelLookup::anchorVtable() const {}
+/* ------------------------------------------------------------------------- */
+/* ========================================================================= */
@@ -0,0 +1,461 @@
+/* ========================================================================= */
+/* ------------------------------------------------------------------------- */
+/*!
+  file         dbmodellookup.h
+  date         October 2026
+  author       agent
+
+  brief        Contains the definition for DbModelLookup class.
+
+*//*
+
+ ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ Please read COPYING and README files in root folder
+ ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+/* ------------------------------------------------------------------------- */
+/* ========================================================================= */
+#ifndef DBMODELLOOKUP_H
+#define DBMODELLOOKUP_H
+//
+//
+//
+//
+/*  INCLUDES    ------------------------------------------------------------ */
+
+#include <dbmodel/dbmodel-config.h>
+#include <dbmodel/dbmodeltbl.h>
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QList>
+#include <QString>
+#include <QVariant>
+#include <QSqlRecord>
+#include <QStringList>
+#include <QModelIndex>
+#include <QElapsedTimer>
+
+/*  INCLUDES    ============================================================ */
+//
+//
+//
+//
+/*  DEFINITIONS    --------------------------------------------------------- */
+
+QT_BEGIN_NAMESPACE
+class QSqlTableModel;
+class QSqlDatabase;
+class QThread;
+QT_END_NAMESPACE
+
+class DbModelManager;
+class DbModelFetcher;
+
+//! Maximum number of keys fetched by a single query in on-demand mode.
+#define DBMODEL_ONDEMAND_BATCH 128
+
+/*  DEFINITIONS    ========================================================= */
+//
+//
+//
+//
+/*  CLASS    --------------------------------------------------------------- */
+
+//! A secondary (lookup) table shared by all models that reference it.
+class DBMODEL_EXPORT DbModelLookup : public QObject {
+    Q_OBJECT
+
+    //
+    //
+    //
+    //
+    /*  DEFINITIONS    ----------------------------------------------------- */
+
+    friend class DbModelManager;
+
+    //! Maps the values in a key column to the row that holds them.
+    template <typename K>
+    struct KeyIndex {
+        QHash<K, int> rows_; /**< first row for each key */
+        int indexed_; /**< number of rows in the model already indexed */
+        QSet<K> missing_; /**< keys fetched but not found */
+
+        KeyIndex () : rows_(), indexed_(0), missing_() {}
+    };
+
+    /*  DEFINITIONS    ===================================================== */
+    //
+    //
+    //
+    //
+    /*  DATA    ------------------------------------------------------------ */
+
+    QString key_; /**< the key in manager's registry (empty if not shared) */
+    QSqlTableModel * model_; /**< the underlying model (owned) */
+    DbModelTbl::LookupMode mode_; /**< how the rows are loaded */
+    QList<QSqlRecord> fetched_; /**< rows loaded in on-demand mode */
+    QList<QSqlRecord> appended_; /**< rows saved to the database after the
+                             model was selected (full mode) */
+    int ref_count_; /**< number of tables using this instance */
+    bool loaded_; /**< the model was selected at least once */
+    bool fresh_; /**< the model was selected in current event loop pass */
+    bool stale_; /**< the database has rows that the model does not */
+    mutable QHash<int, KeyIndex<QString> > key_index_; /**< one index for
+                             each column used as a key by foreign columns */
+    mutable QHash<int, KeyIndex<qint64> > int_index_; /**< same as
+                             `key_index_` for integer key columns */
+    QSet<int> int_keys_; /**< the key columns that hold integers */
+    QHash<int, QList<int> > tuples_; /**< the columns of each composite
+                             key, by the (negative) id used as key column */
+    mutable int generation_; /**< changes each time existing rows are
+                             renumbered or their keys change */
+    mutable int missing_generation_; /**< changes each time new rows
+                             become available (keys that were not found
+                             may be found now) */
+    QThread * thread_; /**< the worker thread (async mode) */
+    DbModelFetcher * fetcher_; /**< loads the rows in worker thread */
+    QHash<int, QSet<QString> > pending_; /**< keys requested from the
+                             worker thread and not received, by column */
+    QHash<int, QSet<QString> > failed_; /**< keys whose query failed, by
+                             column; not queried again until `select()` */
+    DbModelTbl::RefreshPolicy policy_; /**< when is the model selected again */
+    int ttl_; /**< milliseconds the rows are valid (RP_TTL) */
+    QString version_query_; /**< retrieves the version (RP_VERSION) */
+    QVariant version_; /**< the version when the model was selected */
+    QElapsedTimer selected_; /**< started when the model is selected */
+
+    /*  DATA    ============================================================ */
+    //
+    //
+    //
+    //
+    /*  FUNCTIONS    ------------------------------------------------------- */
+
+public:
+
+    //! Constructor; ownership of the model is assumed.
+    DbModelLookup (
+            const QString & key,
+            QSqlTableModel * model,
+            DbModelTbl::LookupMode mode = DbModelTbl::LM_FULL);
+
+    Q_DISABLE_COPY(DbModelLookup)
+
+    //! destructor
+    virtual ~DbModelLookup();
+
+    //! The underlying model.
+    QSqlTableModel *
+    sqlModel () const {
+        return model_;
+    }
+
+    //! Is this instance shared between models?
+    bool
+    isShared () const {
+        return !key_.isEmpty ();
+    }
+
+    //! Number of tables using this instance.
+    int
+    refCount () const {
+        return ref_count_;
+    }
+
+    //! How are the rows loaded.
+    DbModelTbl::LookupMode
+    mode () const {
+        return mode_;
+    }
+
+    //! Are the rows loaded only when their keys are needed?
+    bool
+    isOnDemand () const {
+        return mode_ != DbModelTbl::LM_FULL;
+    }
+
+    //! Are the rows loaded in a worker thread?
+    bool
+    isAsync () const {
+        return mode_ == DbModelTbl::LM_ASYNC;
+    }
+
+    //! Was the model selected at least once?
+    bool
+    isLoaded () const {
+        return loaded_;
+    }
+
+    //! Select the model unless this already happened recently.
+    bool
+    select (
+            bool b_force = false);
+
+    //! When is the model selected again.
+    DbModelTbl::RefreshPolicy
+    refreshPolicy () const {
+        return policy_;
+    }
+
+    //! The argument of the policy (see `setRefreshPolicy()`).
+    QVariant
+    refreshArgument () const;
+
+    //! Change the policy for selecting the model.
+    bool
+    setRefreshPolicy (
+            DbModelTbl::RefreshPolicy value,
+            const QVariant & argument);
+
+    //! Tell if the rows need to be selected again, according to the policy.
+    bool
+    isStale (
+            QVariant & version) const;
+
+    //! Make sure the underlying model has all the rows (for combos).
+    bool
+    ensureModel ();
+
+    //! Number of rows available for lookups.
+    int
+    rowCount () const;
+
+    //! The value in a cell.
+    QVariant
+    value (
+            int row,
+            int col) const;
+
+    //! All the values in a row.
+    QSqlRecord
+    record (
+            int row) const;
+
+    //! Tell if a key was either found or is known to be missing.
+    bool
+    isKnown (
+            int kcol,
+            const QVariant &key) const;
+
+    //! Load the rows for a list of keys (on-demand mode).
+    int
+    fetch (
+            int kcol,
+            const QList<QVariant> & keys);
+
+    //! Queue a list of keys to be loaded in worker thread (async mode).
+    int
+    request (
+            int kcol,
+            const QList<QVariant> & keys);
+
+    //! Tell if a key was requested and did not arrive yet.
+    bool
+    isPending (
+            int kcol,
+            const QVariant &key) const;
+
+    //! Run the queries that load the rows for a list of keys.
+    static bool
+    queryKeys (
+            const QSqlDatabase & db,
+            const QString & table,
+            const QStringList & fields,
+            const QList<QVariant> & keys,
+            QList<QSqlRecord> & rows);
+
+    //! Get the id used as key column for a composite key.
+    int
+    tupleKey (
+            const QList<int> & kcols);
+
+    //! Tell if an id used as key column is a composite key.
+    static bool
+    isTupleKey (
+            int kcol) {
+        return kcol < -1;
+    }
+
+    //! Find the row that holds a key in a column (-1 if not found).
+    int
+    findRow (
+            int kcol,
+            const QVariant &key) const;
+
+    //! Forget the key indexes (the content of the model changed).
+    void
+    clearKeyIndex () const {
+        key_index_.clear ();
+        int_index_.clear ();
+        ++generation_;
+    }
+
+    //! Rows resolved before a change in generation may be wrong.
+    int
+    generation () const {
+        return generation_;
+    }
+
+    //! Keys not found before a change in this generation may be found now.
+    int
+    missingGeneration () const {
+        return missing_generation_;
+    }
+
+    //! Index a key column by integer values instead of generic ones.
+    void
+    setIntegerKey (
+            int kcol);
+
+    //! The key columns indexed by integer values.
+    const QSet<int> &
+    integerKeys () const {
+        return int_keys_;
+    }
+
+    //! Make a row that was saved to the database available for lookups.
+    void
+    appendRecord (
+            const QSqlRecord & rec);
+
+signals:
+
+    //! New rows were loaded in worker thread (async mode).
+    void
+    rowsFetched ();
+
+    //! The rows or the values available for lookups changed.
+    void
+    changed ();
+
+private:
+
+    //! Remember the keys that were searched and not found.
+    int
+    markMissing (
+            int kcol,
+            const QList<QVariant> & keys);
+
+    //! Remember the keys that could not be searched.
+    int
+    markFailed (
+            int kcol,
+            const QList<QVariant> & keys);
+
+    //! The key stored in a row (a list of values for composite keys).
+    QVariant
+    keyValue (
+            int row,
+            int kcol) const;
+
+    //! The key stored in a record (a list of values for composite keys).
+    QVariant
+    keyValue (
+            const QSqlRecord & rec,
+            int kcol) const;
+
+    //! The names of the columns that make up a key.
+    QStringList
+    keyFields (
+            int kcol) const;
+
+    //! Tell if any of the columns that make up a key is in a range.
+    bool
+    isKeyInRange (
+            int kcol,
+            int left,
+            int right) const;
+
+    //! Index the values in a range of rows.
+    template <typename K>
+    void
+    indexRows (
+            KeyIndex<K> & kidx,
+            int kcol,
+            int first,
+            int last) const;
+
+    //! Update the rows in an index after rows were inserted or removed.
+    template <typename K>
+    void
+    shiftRows (
+            KeyIndex<K> & kidx,
+            int kcol,
+            int first,
+            int delta) const;
+
+    //! Update the rows in an index after the values in some rows changed.
+    template <typename K>
+    void
+    updateRows (
+            KeyIndex<K> & kidx,
+            int kcol,
+            int first,
+            int last) const;
+
+    //! Find a key in an index, updating it first.
+    template <typename K>
+    int
+    findRowIn (
+            KeyIndex<K> & kidx,
+            int kcol,
+            const K & key) const;
+
+private slots:
+
+    //! A new pass of the event loop started.
+    void
+    expireFresh ();
+
+    //! The worker thread loaded the rows for a list of keys.
+    void
+    keysFetched (
+            int kcol,
+            const QVariantList & keys,
+            const QVariantList & rows,
+            bool b_complete);
+
+    //! The model was selected or reset.
+    void
+    modelWasReset ();
+
+    //! Rows were inserted in the model.
+    void
+    rowsWereInserted (
+            const QModelIndex & parent,
+            int first,
+            int last);
+
+    //! Rows were removed from the model.
+    void
+    rowsWereRemoved (
+            const QModelIndex & parent,
+            int first,
+            int last);
+
+    //! The values in some cells of the model changed.
+    void
+    dataWasChanged (
+            const QModelIndex & top_left,
+            const QModelIndex & bottom_right);
+
+    /*  FUNCTIONS    ======================================================= */
+    //
+    //
+    //
+    //
+public: virtual void anchorVtable() const;
+}; /* class DbModelLookup */
+
+/*  CLASS    =============================================================== */
+//
+//
+//
+//
+
+
+#endif // DBMODELLOOKUP_H
+/* ------------------------------------------------------------------------- */
+/* ========================================================================= */
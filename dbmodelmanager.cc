@@ -22,9 +22,18 @@
 /*  INCLUDES    ------------------------------------------------------------ */
 
 #include "dbmodelmanager.h"
+#include "dbmodellookup.h"
+#include "dbmodelprivate.h"
+
+#include <dbstruct/dbstruct.h>
+#include <dbstruct/dbtaew.h>
 
 #include <QApplication>
 #include <QStyle>
+#include <QSqlDatabase>
+#include <QSqlTableModel>
+
+#include <assert.h>
 
 /*  INCLUDES    ============================================================ */
 //
@@ -69,6 +78,12 @@ void DbModelManager::end ()
             break;
         }
 
+        // lookups still in use by some models will be deleted
+        // when those models release them
+        foreach(DbModelLookup * lookup, uniq_->lookups_) {
+            lookup->key_.clear ();
+        }
+        uniq_->lookups_.clear ();
 
         delete uniq_;
         uniq_ = NULL;
@@ -83,7 +98,9 @@ DbModelManager::DbModelManager() :
         QApplication::instance() == NULL ?
             QIcon() :
             QApplication::style()->standardIcon (QStyle::SP_MediaPlay)),
-    crt_color_marker_(QColor (255, 255, 153))
+    crt_color_marker_(QColor (255, 255, 153)),
+    placeholder_("..."),
+    lookups_()
 {
 }
 /* ========================================================================= */
@@ -95,6 +112,97 @@ DbModelManager::~DbModelManager()
 }
 /* ========================================================================= */
 
+/* ------------------------------------------------------------------------- */
+/**
+ * Shared lookups are identified by the name of the database connection and
+ * the name of the table. If the registry already has an entry its
+ * reference count is incremented and the instance is returned; otherwise
+ * a new model is created for the table and registered.
+ *
+ * If the manager was not initialized or if \b b_shared is false
+ * a private instance is created. Private instances are used for tables
+ * with their own filter or order.
+ *
+ * Lookups in different modes are never shared.
+ *
+ * Each call must be paired with a call to `releaseLookup()`.
+ *
+ * @param db the database that holds the table
+ * @param meta the table or view that is referenced
+ * @param b_shared share the instance with other models
+ * @param mode how the rows are loaded
+ * @return NULL if the input is invalid
+ */
+DbModelLookup * DbModelManager::acquireLookup (
+        DbStruct * db, DbTaew * meta, bool b_shared,
+        DbModelTbl::LookupMode mode)
+{
+    DbModelLookup * result = NULL;
+    for (;;) {
+        if ((db == NULL) || (meta == NULL)) {
+            break;
+        }
+
+        QSqlDatabase sqldb = db->database ();
+        QString key;
+        if (b_shared && (uniq_ != NULL)) {
+            key = QString ("%1::%2")
+                    .arg (sqldb.connectionName ())
+                    .arg (meta->tableName ());
+            if (mode == DbModelTbl::LM_ONDEMAND) {
+                key.append ("::ondemand");
+            } else if (mode == DbModelTbl::LM_ASYNC) {
+                key.append ("::async");
+            }
+            result = uniq_->lookups_.value (key, NULL);
+            if (result != NULL) {
+                ++result->ref_count_;
+                break;
+            }
+        }
+
+        result = new DbModelLookup (
+                    key, meta->sqlModel (sqldb, NULL), mode);
+        ++result->ref_count_;
+        if (!key.isEmpty ()) {
+            uniq_->lookups_.insert (key, result);
+        }
+        break;
+    }
+    return result;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The instance is deleted when the last user releases it.
+ *
+ * @param value the instance to release; NULL is silently ignored
+ */
+void DbModelManager::releaseLookup (DbModelLookup * value)
+{
+    for (;;) {
+        if (value == NULL) {
+            break;
+        }
+
+        assert(value->ref_count_ > 0);
+        --value->ref_count_;
+        if (value->ref_count_ > 0) {
+            break;
+        }
+
+        if ((uniq_ != NULL) && value->isShared ()) {
+            if (uniq_->lookups_.value (value->key_, NULL) == value) {
+                uniq_->lookups_.remove (value->key_);
+            }
+        }
+        delete value;
+        break;
+    }
+}
+/* ========================================================================= */
+
 /*  CLASS    =============================================================== */
 //
 //
@@ -24,9 +24,12 @@
 /*  INCLUDES    ------------------------------------------------------------ */
 
 #include <dbmodel/dbmodel-config.h>
+#include <dbmodel/dbmodeltbl.h>
 
 #include <QIcon>
 #include <QColor>
+#include <QHash>
+#include <QString>
 
 /*  INCLUDES    ============================================================ */
 //
@@ -35,6 +38,10 @@
 //
 /*  DEFINITIONS    --------------------------------------------------------- */
 
+class DbStruct;
+class DbTaew;
+class DbModelLookup;
+
 /*  DEFINITIONS    ========================================================= */
 //
 //
@@ -62,6 +69,9 @@ private:
 
     QIcon crt_icon_marker_; /**< Icon used to indicate current items */
     QColor crt_color_marker_; /**< Background used to indicate current items */
+    QString placeholder_; /**< Shown while foreign values are being loaded */
+    QHash<QString, DbModelLookup *> lookups_; /**< shared secondary tables
+                                              by connection and table name */
     static DbModelManager * uniq_; /**< The one and only instance */
 
     /*  DATA    ============================================================ */
@@ -105,6 +115,37 @@ public:
         uniq_->crt_color_marker_ = value;
     }
 
+    //! Retrieve the text shown while foreign values are being loaded.
+    static QString
+    getPlaceholder () {
+        return uniq_ == NULL ? QString ("...") : uniq_->placeholder_;
+    }
+
+    //! Set the text shown while foreign values are being loaded.
+    static void
+    setPlaceholder (const QString & value) {
+        uniq_->placeholder_ = value;
+    }
+
+    //! Get the lookup for a table; a new one is created if needed.
+    static DbModelLookup *
+    acquireLookup (
+            DbStruct * db,
+            DbTaew * meta,
+            bool b_shared = true,
+            DbModelTbl::LookupMode mode = DbModelTbl::LM_FULL);
+
+    //! Release a lookup acquired with `acquireLookup()`.
+    static void
+    releaseLookup (
+            DbModelLookup * value);
+
+    //! Number of distinct shared lookups.
+    static int
+    lookupCount () {
+        return uniq_ == NULL ? 0 : uniq_->lookups_.count ();
+    }
+
 
 protected:
 
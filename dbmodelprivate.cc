@@ -23,6 +23,9 @@
 
 #include "dbmodelprivate.h"
 #include "dbmodelmanager.h"
+#include "dbmodelsql.h"
+#include "dbmodellookup.h"
+#include "dbmodellocale.h"
 #include "dbmodel.h"
 
 #include <dbstruct/dbtable.h>
@@ -75,9 +78,20 @@ DbModelPrivate::DbModelPrivate(DbStruct * db, DbTaew * meta, DbModel * parent) :
     tables_(),
     row_highlite_(-1),
     col_highlite_(-1),
-    user_data_(NULL)
+    user_data_(NULL),
+    foreign_mode_(DbModelTbl::FM_LOOKUP),
+    columnar_(false),
+    cells_(DBMODEL_CELL_CACHE),
+    cell_roles_()
 {
     DBMODEL_TRACE_ENTRY;
+    connect (this, SIGNAL(dataChanged(QModelIndex,QModelIndex)),
+             this, SLOT(rowsChanged(QModelIndex,QModelIndex)));
+    connect (this, SIGNAL(modelReset()),
+             this, SLOT(forgetCells()));
+    connect (this, SIGNAL(layoutChanged()),
+             this, SLOT(forgetCells()));
+    watchLocale ();
     loadMeta (meta);
     DBMODEL_TRACE_EXIT;
 }
@@ -98,9 +112,20 @@ DbModelPrivate::DbModelPrivate(DbStruct * db, int component, DbModel * parent) :
     tables_(),
     row_highlite_(-1),
     col_highlite_(-1),
-    user_data_(NULL)
+    user_data_(NULL),
+    foreign_mode_(DbModelTbl::FM_LOOKUP),
+    columnar_(false),
+    cells_(DBMODEL_CELL_CACHE),
+    cell_roles_()
 {
     DBMODEL_TRACE_ENTRY;
+    connect (this, SIGNAL(dataChanged(QModelIndex,QModelIndex)),
+             this, SLOT(rowsChanged(QModelIndex,QModelIndex)));
+    connect (this, SIGNAL(modelReset()),
+             this, SLOT(forgetCells()));
+    connect (this, SIGNAL(layoutChanged()),
+             this, SLOT(forgetCells()));
+    watchLocale ();
     DbTaew * meta = NULL;
     if (db != NULL) {
         meta = db->metaDatabase()->taew (component);
@@ -197,10 +222,18 @@ bool DbModelPrivate::selectMe ()
     }
     beginResetModel ();
     bool b_ret = true;
+    int i = 0;
     foreach(const DbModelTbl & tbl, tables_) {
         QSqlTableModel * model = tbl.sqlModel ();
         if (model == NULL) {
             b_ret = false;
+        } else if (!isTableNeeded (i)) {
+            // joined by main query; loaded only if the user needs it
+        } else if (tbl.lookup () != NULL) {
+            // lookups report their own errors and are only
+            // selected if stale according to their refresh policy
+            bool loc_b_ret = tbl.select ();
+            b_ret = b_ret && loc_b_ret;
         } else {
             bool loc_b_ret = model->select ();
             if (!loc_b_ret) {
@@ -217,7 +250,10 @@ bool DbModelPrivate::selectMe ()
 #           endif
             b_ret = b_ret && loc_b_ret;
         }
+        ++i;
     }
+    tables_.first ().clearResolved ();
+    forgetCells ();
     endResetModel ();
     // model->setJoinMode (QSqlRelationalTableModel::LeftJoin);
 
@@ -298,6 +334,13 @@ bool DbModelPrivate::setFilter (const QString & filter, int table_index)
             break;
         }
 
+        // the filter must not leak into other models
+        DbModelLookup * prev = tables_[table_index].lookup ();
+        if (!tables_[table_index].detachLookup (db_)) {
+            break;
+        }
+        lookupReplaced (table_index, prev);
+
         QSqlTableModel * model = tables_[table_index].sqlModel ();
         if (model == NULL) {
             DBMODEL_DEBUGM("Table %d is invalid\n",
@@ -307,6 +350,8 @@ bool DbModelPrivate::setFilter (const QString & filter, int table_index)
 
         model->setFilter (filter);
         // ! Not calling model->select (); !
+        tables_.first ().clearResolved ();
+        forgetCells ();
 
         b_ret = true;
         break;
@@ -348,6 +393,10 @@ bool DbModelPrivate::setFilter (const QString & filter, const QString & table)
  * To set the sorting order for this model's main table call
  * the method without the \b table_index parameter.
  *
+ * Foreign columns (including virtual ones) in main table are sorted
+ * by the database on the value they show, either through the join
+ * (DbModelTbl::FM_JOIN) or through a subquery on the secondary table.
+ *
  * @param column the column to use for sorting;
  * @param order the order to apply to sid column
  * @param table_index the index of the table
@@ -364,6 +413,13 @@ bool DbModelPrivate::setOrder (int column, Qt::SortOrder order, int table_index)
             break;
         }
 
+        // the order must not leak into other models
+        DbModelLookup * prev = tables_[table_index].lookup ();
+        if (!tables_[table_index].detachLookup (db_)) {
+            break;
+        }
+        lookupReplaced (table_index, prev);
+
         QSqlTableModel * model = tables_[table_index].sqlModel ();
         if (model == NULL) {
             DBMODEL_DEBUGM("Table %d is invalid\n",
@@ -371,25 +427,37 @@ bool DbModelPrivate::setOrder (int column, Qt::SortOrder order, int table_index)
             break;
         }
 
-        if ((column < 0) && (column >= columnCount ())) {
+        if ((column < 0) || (column >= columnCount ())) {
             DBMODEL_DEBUGM("%d is out of bounds for columns [0, %d)\n",
                            column, columnCount());
             break;
         }
 
+        // main model is always a DbModelSql (see `loadMeta()`)
+        DbModelSql * main = table_index == 0 ?
+                    static_cast<DbModelSql *>(model) : NULL;
+
         // if this is a regular column then is easy
         const DbModelCol & c = columnData (column);
         if (!c.isForeign()) {
-            model->sort (c.mainTableRealIndex(), order);
+            if (main != NULL)
+                main->clearForeignOrder ();
+            tables_[table_index].setSort (c.mainTableRealIndex(), order);
+        } else {
+            // the database sorts on the value shown by the column
+            if (main == NULL) {
+                DBMODEL_DEBUGM("Foreign columns can only be sorted "
+                               "in main table\n");
+                break;
+            }
+            if (!tables_.first ().setupOrder (main, column, order)) {
+                break;
+            }
+            main->select ();
         }
-
-
-
-
-    /** @todo */
-
-
-
+        tables_[table_index].clearKeyIndex ();
+        tables_.first ().clearResolved ();
+        forgetCells ();
 
         b_ret = true;
         break;
@@ -474,11 +542,8 @@ Qt::ItemFlags DbModelPrivate::flags (const QModelIndex &idx) const
         if (!validateIndex (idx))
             break;
 
-        // data for this column in main table
-        const DbModelCol & column = columnData (idx.column());
-
         // Only allow editing if this is allowed in the model
-        if (!column.original_.readOnly ()) {
+        if (tables_.first ().columnStyle (idx.column())->editable_) {
             result = result | Qt::ItemIsEditable;
         }
 
@@ -709,6 +774,8 @@ bool DbModelPrivate::removeRows (int row, int count, const QModelIndex &)
     if (!isValid())
         return false;
     if (tables_.first().sqlModel()->removeRows (row, count)) {
+        tables_.first ().clearResolved ();
+        forgetCells ();
         DBMODEL_DEBUGM ("%d row(s) removed starting at %d\n", count, row);
         return true;
     } else {
@@ -721,6 +788,29 @@ bool DbModelPrivate::removeRows (int row, int count, const QModelIndex &)
 
 /* ------------------------------------------------------------------------- */
 QVariant DbModelPrivate::data (const QModelIndex & idx, int role) const
+{
+    if (cells_.maxCost () <= 0)
+        return cellData (idx, role);
+
+    CellKey key (idx.row (), idx.column (), role);
+    QVariant * cached = cells_.object (key);
+    if (cached != NULL)
+        return *cached;
+
+    QVariant result = cellData (idx, role);
+    if (validateIndex (idx)) {
+        cells_.insert (key, new QVariant (result));
+        cell_roles_.insert (role);
+    }
+    return result;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The values are cached by `data()`; this method computes them.
+ */
+QVariant DbModelPrivate::cellData (const QModelIndex & idx, int role) const
 {
     for (;;) {
 
@@ -735,18 +825,27 @@ QVariant DbModelPrivate::data (const QModelIndex & idx, int role) const
 
         // Read-only columns have distinctive colors; otherwise we
         // use default processing for these characteristics.
-        if (role == Qt::TextColorRole) {
-            // read-only items are shown in a lighter font
-            Qt::ItemFlags flgs = flags (idx);
-            bool beditable = flgs & Qt::ItemIsEditable;
-            if (beditable) {
+        if ((role == Qt::TextColorRole) || (role == Qt::TextAlignmentRole)) {
+            // the properties of the column don't depend on the row
+            const DbModelTbl::ColStyle * style = tables_.isEmpty () ?
+                        NULL : tables_.first ().columnStyle (idx.column ());
+            if (style == NULL) {
+                if (role == Qt::TextColorRole)
+                    return QColor(Qt::darkGray);
                 break;
-            } else {
-                return QColor(Qt::darkGray);
+            }
+            if (role == Qt::TextColorRole) {
+                if (style->text_color_.isValid ())
+                    return style->text_color_;
+                break;
+            } else if (style->alignment_.isValid ()) {
+                return style->alignment_;
             }
         } else if (role == Qt::BackgroundColorRole) {
-            QVariant editdata = data(idx, Qt::EditRole);
-            if (editdata.isNull()) {
+            bool b_null = !validateIndex (idx) ||
+                    tables_.first ().isNullCell (
+                        this, idx.row (), idx.column ());
+            if (b_null) {
                 // return QColor(224, 235, 235); // bluish
                 return QColor(255, 242, 229); // reddish
             } else {
@@ -932,6 +1031,8 @@ bool DbModelPrivate::setData (
                          TMP_A(model->query().lastQuery()));
 #           endif
             model->submit();
+            tables_.first ().clearResolved ();
+            forgetCells ();
             emit dataChanged (idx, idx);
             return true;
         } else {
@@ -1046,9 +1147,13 @@ bool DbModelPrivate::loadMeta (DbTaew * meta)
     if ((meta != NULL) && (db_ != NULL)) {
 
         // inform underlying table about the table we're gonna use
-        QSqlTableModel * main = new QSqlTableModel (this, db_->database());
+        DbModelSql * main = new DbModelSql (this, db_->database());
         main->setTable (meta->tableName ());
         main->setEditStrategy (QSqlTableModel::OnFieldChange);
+        connect (main, SIGNAL(dataChanged(QModelIndex,QModelIndex)),
+                 this, SLOT(mainRowsChanged(QModelIndex,QModelIndex)));
+        connect (main, SIGNAL(modelReset()),
+                 this, SLOT(mainReset()));
 
         // our table is always at position 0
         assert(tables_.count() == 0);
@@ -1059,7 +1164,10 @@ bool DbModelPrivate::loadMeta (DbTaew * meta)
         this_table.setSqlModel (main);
         this_table.setMetadata (meta);
         this_table.constructColumns (this);
-
+        if (foreign_mode_ == DbModelTbl::FM_JOIN) {
+            this_table.setupJoins (main);
+        }
+        this_table.setColumnarStore (columnar_);
 
         b_ret = true;
     }
@@ -1108,7 +1216,13 @@ const DbModelTbl & DbModelPrivate::table (const QString & name)
         DBMODEL_DEBUGM("The database does not contain a table called %s\n",
                        TMP_A(name));
     } else {
-        new_tbl.setSqlModel (intermed->sqlModel (db_->database(), this));
+        new_tbl.setLookup (DbModelManager::acquireLookup (db_, intermed));
+        if (new_tbl.lookup () != NULL) {
+            connect (new_tbl.lookup (), SIGNAL(changed()),
+                     this, SLOT(forgetCells()), Qt::UniqueConnection);
+            connect (new_tbl.lookup (), SIGNAL(changed()),
+                     this, SIGNAL(lookupChanged()), Qt::UniqueConnection);
+        }
     }
     new_tbl.setMetadata (intermed);
     new_tbl.constructColumns (this);
@@ -1125,6 +1239,9 @@ void DbModelPrivate::clearTables ()
     int i_max = tables_.count();
     for (int i = 0; i < i_max; ++i) {
         DbModelTbl & crt = tables_[i];
+        if (crt.lookup () != NULL) {
+            crt.lookup ()->disconnect (this);
+        }
         crt.destroy();
     }
     tables_.clear();
@@ -1142,15 +1259,603 @@ QSqlRecord DbModelPrivate::record (int row) const
 }
 /* ========================================================================= */
 
+/* ------------------------------------------------------------------------- */
+/**
+ * The alignment is kept with the other properties that are the same
+ * for all the rows in a column.
+ *
+ * @param column the index of the column
+ * @param value a Qt::Alignment or an invalid value for default processing
+ * @return false if the index is out of bounds
+ */
+bool DbModelPrivate::setColumnAlignment (int column, const QVariant & value)
+{
+    bool b_ret = false;
+    for (;;) {
+        if (tables_.count () == 0)
+            break;
+        if (!tables_[0].setColumnAlignment (column, value)) {
+            DBMODEL_DEBUGM("%d is not a valid column index\n", column);
+            break;
+        }
+        if (rowCount () > 0) {
+            emit dataChanged (index (0, column),
+                              index (rowCount () - 1, column));
+        }
+        b_ret = true;
+        break;
+    }
+    return b_ret;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The setting survives `setMeta()`; the copy is made the next time
+ * the rows are read.
+ *
+ * @param b_enable true to keep a typed copy of the rows
+ */
+void DbModelPrivate::setColumnarStore (bool b_enable)
+{
+    columnar_ = b_enable;
+    if (tables_.count () > 0) {
+        tables_[0].setColumnarStore (b_enable);
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * @param row the row in this model
+ * @return a view of the row in main table (invalid if the model
+ * is not valid)
+ */
+DbModelRow DbModelPrivate::rowView (int row) const
+{
+    if (tables_.count () == 0)
+        return DbModelRow ();
+    return tables_.first ().rowView (row);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The indexes are validated once for the whole block and, for display
+ * and edit roles, the values are taken straight from the main table;
+ * the record of a row is retrieved once and shared by all dynamic
+ * columns that don't have a row callback. Other roles go
+ * through `data()` for each cell.
+ *
+ * @param rows the rows in this model
+ * @param columns the columns
+ * @param role the role
+ * @param values receives the values, row by row (each row has
+ * one value for each entry in `columns`)
+ * @return false if an index is not valid
+ */
+bool DbModelPrivate::fetchBlock (
+        const QVector<int> & rows, const QList<int> & columns, int role,
+        QVector<QVariant> & values) const
+{
+    DBMODEL_TRACE_ENTRY;
+    bool b_ret = false;
+    for (;;) {
+        values.clear ();
+        if (!isValid ())
+            break;
+
+        int row_count = rowCount ();
+        int col_count = columnCount ();
+        const DbModelTbl & main_table = tables_.first ();
+        bool b_dynamic = false;
+        bool b_valid = true;
+        foreach (int col, columns) {
+            if ((col < 0) || (col >= col_count)) {
+                DBMODEL_DEBUGM("Column %d is out of valid range [0, %d)\n",
+                               col, col_count);
+                b_valid = false;
+                break;
+            }
+            const DbModelCol & column = main_table.columnData (col);
+            if (column.original_.isDynamic () &&
+                    (column.rowCallback () == NULL)) {
+                b_dynamic = true;
+            }
+        }
+        foreach (int row, rows) {
+            if ((row < 0) || (row >= row_count)) {
+                DBMODEL_DEBUGM("Row %d is out of valid range [0, %d)\n",
+                               row, row_count);
+                b_valid = false;
+                break;
+            }
+        }
+        if (!b_valid)
+            break;
+
+        values.resize (rows.count () * columns.count ());
+        bool b_direct = (role == Qt::DisplayRole) || (role == Qt::EditRole);
+        QVariant * out = values.data ();
+        foreach (int row, rows) {
+            if (b_direct) {
+                QSqlRecord rec;
+                if (b_dynamic)
+                    rec = main_table.record (row);
+                foreach (int col, columns) {
+                    *out++ = main_table.data (
+                                this, row, col, role,
+                                b_dynamic ? &rec : NULL);
+                }
+            } else {
+                foreach (int col, columns) {
+                    *out++ = data (index (row, col), role);
+                }
+            }
+        }
+        b_ret = true;
+        break;
+    }
+    DBMODEL_TRACE_EXIT;
+    return b_ret;
+}
+/* ========================================================================= */
+
 /* ------------------------------------------------------------------------- */
 void DbModelPrivate::reloadHeaders ()
 {
     beginResetModel();
     tables_[0].retrieveLabels ();
+    for (int i = 0; i < tables_.count (); ++i) {
+        tables_[i].compileFormats ();
+    }
     endResetModel();
 }
 /* ========================================================================= */
 
+/* ------------------------------------------------------------------------- */
+/**
+ * Dates, times and numbers may be presented according to the locale,
+ * so the cached values are forgotten and the views are told that all
+ * the cells changed.
+ */
+void DbModelPrivate::reloadFormats ()
+{
+    for (int i = 0; i < tables_.count (); ++i) {
+        tables_[i].compileFormats ();
+    }
+    forgetCells ();
+    if ((rowCount () > 0) && (columnCount () > 0)) {
+        emit dataChanged (index (0, 0),
+                          index (rowCount () - 1, columnCount () - 1));
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The formats are built again when the locale of the system changes
+ * (see DbModelLocaleWatcher). Applications that call
+ * `QLocale::setDefault()` should call DbModel::reloadFormats()
+ * themselves.
+ */
+void DbModelPrivate::watchLocale ()
+{
+    DbModelLocaleWatcher * watcher = DbModelLocaleWatcher::instance ();
+    if (watcher != NULL) {
+        connect (watcher, SIGNAL(localeChanged()),
+                 this, SLOT(localeChanged()));
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void DbModelPrivate::localeChanged ()
+{
+    reloadFormats ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * In DbModelTbl::FM_JOIN mode the values for most foreign columns are
+ * retrieved by the main query, so the secondary tables are not
+ * selected by `selectMe()`.
+ *
+ * Only the statement of the main table and the columns that are
+ * joined change; filters, sorting, labels, callbacks and the settings
+ * of the secondary tables are preserved. If the model was selected
+ * it is selected again.
+ *
+ * @param value the new mode
+ */
+void DbModelPrivate::setForeignMode (DbModelTbl::ForeignMode value)
+{
+    DBMODEL_TRACE_ENTRY;
+    for (;;) {
+        if (value == foreign_mode_) {
+            break;
+        }
+        foreign_mode_ = value;
+        if (tables_.count () == 0) {
+            break;
+        }
+
+        // main model is always a DbModelSql (see `loadMeta()`)
+        DbModelTbl & main_table = tables_.first ();
+        DbModelSql * main = static_cast<DbModelSql *>(main_table.sqlModel ());
+        if (main == NULL) {
+            break;
+        }
+        bool b_selected = main->query ().isActive ();
+
+        beginResetModel ();
+        if (value == DbModelTbl::FM_JOIN) {
+            main_table.setupJoins (main);
+        } else {
+            main_table.clearJoins (main);
+        }
+        main_table.clearResolved ();
+        forgetCells ();
+        endResetModel ();
+
+        if (b_selected) {
+            selectMe ();
+        }
+        break;
+    }
+    DBMODEL_TRACE_EXIT;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Secondary tables that reference a large number of rows of which
+ * only a few are actually used should be switched to
+ * DbModelTbl::LM_ONDEMAND mode. The table then starts empty and the
+ * rows are loaded in batches as the keys are needed.
+ *
+ * In DbModelTbl::LM_ASYNC mode the cells show a placeholder until the
+ * rows arrive from the worker thread, then `dataChanged()` is emitted
+ * for the rows that showed placeholders.
+ *
+ * @param value the new mode
+ * @param table_index the index of the secondary table
+ * @return false if the index is out of bounds or is the main table
+ */
+bool DbModelPrivate::setLookupMode (
+        DbModelTbl::LookupMode value, int table_index)
+{
+    bool b_ret = false;
+    beginResetModel();
+    for (;;) {
+        if ((table_index < 1) || (table_index >= tables_.count())) {
+            DBMODEL_DEBUGM("%d is out of bounds for secondary tables [1, %d)\n",
+                           table_index, tables_.count());
+            break;
+        }
+
+        DbModelLookup * prev = tables_[table_index].lookup ();
+        b_ret = tables_[table_index].setLookupMode (db_, value);
+        lookupReplaced (table_index, prev);
+        break;
+    }
+    endResetModel();
+    return b_ret;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+bool DbModelPrivate::setLookupMode (
+        DbModelTbl::LookupMode value, const QString & table)
+{
+    bool b_ret = false;
+    for (;;) {
+        int table_index = findTable (table);
+        if (table_index == -1) {
+            DBMODEL_DEBUGM("This model does not contain a table called %s\n",
+                           TMP_A(table));
+            break;
+        }
+
+        b_ret = setLookupMode (value, table_index);
+        break;
+    }
+    return b_ret;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * `selectMe()` always selects the main table but only selects
+ * the secondary tables that are stale according to their policy.
+ * Tables like a list of countries can use DbModelTbl::RP_MANUAL
+ * and be refreshed with `refreshTable()` when they are known to change.
+ *
+ * @param value the new policy
+ * @param table_index the index of the secondary table
+ * @param argument the number of milliseconds for DbModelTbl::RP_TTL;
+ * the statement that retrieves the version for DbModelTbl::RP_VERSION
+ * @return false if the index is out of bounds or is the main table
+ */
+bool DbModelPrivate::setRefreshPolicy (
+        DbModelTbl::RefreshPolicy value, int table_index,
+        const QVariant & argument)
+{
+    bool b_ret = false;
+    for (;;) {
+        if ((table_index < 1) || (table_index >= tables_.count())) {
+            DBMODEL_DEBUGM("%d is out of bounds for secondary tables [1, %d)\n",
+                           table_index, tables_.count());
+            break;
+        }
+
+        b_ret = tables_[table_index].setRefreshPolicy (value, argument);
+        break;
+    }
+    return b_ret;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+bool DbModelPrivate::setRefreshPolicy (
+        DbModelTbl::RefreshPolicy value, const QString & table,
+        const QVariant & argument)
+{
+    bool b_ret = false;
+    for (;;) {
+        int table_index = findTable (table);
+        if (table_index == -1) {
+            DBMODEL_DEBUGM("This model does not contain a table called %s\n",
+                           TMP_A(table));
+            break;
+        }
+
+        b_ret = setRefreshPolicy (value, table_index, argument);
+        break;
+    }
+    return b_ret;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * @param table_index the index of the table (0 selects the whole model)
+ * @return false if the index is out of bounds or the select failed
+ */
+bool DbModelPrivate::refreshTable (int table_index)
+{
+    bool b_ret = false;
+    for (;;) {
+        if ((table_index < 0) || (table_index >= tables_.count())) {
+            DBMODEL_DEBUGM("%d is out of bounds for tables [0, %d)\n",
+                           table_index, tables_.count());
+            break;
+        }
+        if (table_index == 0) {
+            b_ret = selectMe ();
+            break;
+        }
+
+        beginResetModel ();
+        b_ret = tables_.at (table_index).select (true);
+        tables_.first ().clearResolved ();
+        forgetCells ();
+        endResetModel ();
+        break;
+    }
+    return b_ret;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Called after a secondary table was given another lookup (a private
+ * one or one with another mode), inside a model reset. The rows
+ * resolved in any table may point into the old lookup, so they are
+ * all forgotten, and the composite keys of the columns that reference
+ * the table are registered with the new one. The cached cells follow
+ * the changes of the new lookup (including the ones made by other
+ * models) and placeholders shown for an asynchronous lookup are
+ * replaced when it reports its rows.
+ *
+ * @param table_index the index of the secondary table
+ * @param prev the lookup used by the table before the change
+ */
+void DbModelPrivate::lookupReplaced (int table_index, DbModelLookup * prev)
+{
+    DbModelLookup * crt = tables_.at (table_index).lookup ();
+    if (prev == crt)
+        return;
+
+    if (prev != NULL) {
+        prev->disconnect (this);
+    }
+    if (crt != NULL) {
+        connect (crt, SIGNAL(changed()),
+                 this, SLOT(forgetCells()), Qt::UniqueConnection);
+        connect (crt, SIGNAL(changed()),
+                 this, SIGNAL(lookupChanged()), Qt::UniqueConnection);
+        if (crt->isAsync ()) {
+            connect (crt, SIGNAL(rowsFetched()),
+                     this, SLOT(lookupFetched()), Qt::UniqueConnection);
+        }
+    }
+
+    const DbModelTbl * secondary = &tables_.at (table_index);
+    int i_max = tables_.count ();
+    for (int i = 0; i < i_max; ++i) {
+        tables_[i].registerKeys (secondary);
+        tables_.at (i).clearResolved ();
+    }
+    forgetCells ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Shared tables also report the rows requested by other models, so
+ * nothing happens unless this model shows placeholders.
+ */
+void DbModelPrivate::lookupFetched ()
+{
+    if (tables_.count () == 0)
+        return;
+
+    int first;
+    int last;
+    if (!tables_.first ().takeWaiting (first, last))
+        return;
+
+    last = qMin (last, rowCount () - 1);
+    if (first > last)
+        return;
+    emit dataChanged (index (first, 0), index (last, columnCount () - 1));
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Results of dynamic columns are cached by the main table and final
+ * values are cached by this model; any change in a row may change them.
+ *
+ * @param top_left first changed cell
+ * @param bottom_right last changed cell
+ */
+void DbModelPrivate::rowsChanged (
+        const QModelIndex & top_left, const QModelIndex & bottom_right)
+{
+    forgetCells (top_left.row (), bottom_right.row ());
+    if (tables_.count () == 0)
+        return;
+    tables_.first ().clearDynamic (top_left.row (), bottom_right.row ());
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The sql model changes on its own when an edit is submitted or
+ * reverted, so the values cached for the rows it reports are
+ * forgotten (the rows are the same in both models).
+ *
+ * @param top_left first changed cell
+ * @param bottom_right last changed cell
+ */
+void DbModelPrivate::mainRowsChanged (
+        const QModelIndex & top_left, const QModelIndex & bottom_right)
+{
+    if (tables_.count () == 0)
+        return;
+    int first = top_left.row ();
+    int last = qMin (bottom_right.row (), rowCount () - 1);
+    for (int i = first; i <= last; ++i) {
+        tables_.first ().clearResolved (i);
+    }
+    forgetCells (first, last);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void DbModelPrivate::mainReset ()
+{
+    if (tables_.count () == 0)
+        return;
+    tables_.first ().clearResolved ();
+    forgetCells ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The cells of a few rows are removed one by one, for all the columns
+ * and the roles that were cached; if that means more keys than
+ * the cache can hold, the whole cache is cleared instead.
+ *
+ * @param first the first row to forget or -1 for all rows
+ * @param last the last row to forget (inclusive)
+ */
+void DbModelPrivate::forgetCells (int first, int last) const
+{
+    if (cells_.isEmpty ())
+        return;
+
+    int col_count = columnCount ();
+    qint64 keys = static_cast<qint64>(last - first + 1) *
+            col_count * cell_roles_.count ();
+    if ((first == -1) || (keys > cells_.maxCost ())) {
+        cells_.clear ();
+        cell_roles_.clear ();
+        return;
+    }
+    for (int row = first; row <= last; ++row) {
+        for (int col = 0; col < col_count; ++col) {
+            foreach (int role, cell_roles_) {
+                cells_.remove (CellKey (row, col, role));
+            }
+        }
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void DbModelPrivate::forgetCells ()
+{
+    forgetCells (-1, -1);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The cache keeps the final values returned by `data()` for
+ * the cells that were most recently used, so that views that paint
+ * the same cells over and over only pay for a hash lookup.
+ *
+ * @param value maximum number of values (0 disables the cache)
+ */
+void DbModelPrivate::setCellCacheSize (int value)
+{
+    cells_.setMaxCost (qMax (0, value));
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The main table is always needed. A secondary table is needed if
+ * a foreign column that is not joined by the main query shows values
+ * from it, either directly or through another secondary table.
+ *
+ * @param table_index the index of the table in `tables_`
+ * @return true if the table should be selected
+ */
+bool DbModelPrivate::isTableNeeded (int table_index) const
+{
+    if (table_index == 0)
+        return true;
+    if ((table_index < 0) || (table_index >= tables_.count ()))
+        return false;
+    if (foreign_mode_ == DbModelTbl::FM_LOOKUP)
+        return true;
+
+    const DbModelTbl * target = &tables_.at (table_index);
+    QList<const DbModelTbl *> needed;
+    needed.append (&tables_.first ());
+    for (int t = 0; t < needed.count (); ++t) {
+        const DbModelTbl * crt = needed.at (t);
+        int i_max = crt->columnCount ();
+        for (int i = 0; i < i_max; ++i) {
+            const DbModelCol & col = crt->columnData (i);
+            if (!col.isForeign () || col.isJoined ())
+                continue;
+            if (col.table_ == target)
+                return true;
+            if (!needed.contains (col.table_))
+                needed.append (col.table_);
+        }
+    }
+    return false;
+}
+/* ========================================================================= */
+
 /* ------------------------------------------------------------------------- */
 /**
  * The method checks the input against current valid range and stores the
@@ -1182,6 +1887,12 @@ bool DbModelPrivate::setCurrentMarker (int row, int column)
 //            break;
 //        }
 
+        // the decoration of the old and new cells changes
+        if (row_highlite_ != -1)
+            forgetCells (row_highlite_, row_highlite_);
+        if (row != -1)
+            forgetCells (row, row);
+
         // save the values
         col_highlite_ = column;
         row_highlite_ = row;
@@ -1209,6 +1920,7 @@ bool DbModelPrivate::setColumnCallback (
 
         DbModelTbl & tbl = tables_[table_index];
         b_ret = tbl.setColumnCallback (column_index, value);
+        forgetCells ();
 
         user_data_ = user_data;
         break;
@@ -1240,6 +1952,76 @@ DbColKb DbModelPrivate::columnCallback (
 }
 /* ========================================================================= */
 
+/* ------------------------------------------------------------------------- */
+bool DbModelPrivate::setBatchCallback (
+        int table_index, int column_index, DbColBatchKb value,
+        void * user_data)
+{
+    bool b_ret = false;
+    for (;;) {
+        if ((table_index < 0) || (table_index >= tables_.count())) {
+            DBMODEL_DEBUGM("Can't set batch callback for column; index %d "
+                           "is out of valid range [0, %d) for tables\n",
+                           table_index, tables_.count());
+            break;
+        }
+
+        DbModelTbl & tbl = tables_[table_index];
+        b_ret = tbl.setBatchCallback (column_index, value);
+        forgetCells ();
+
+        user_data_ = user_data;
+        break;
+    }
+    return b_ret;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+bool DbModelPrivate::setRowCallback (
+        int table_index, int column_index, DbColRowKb value,
+        void * user_data)
+{
+    bool b_ret = false;
+    for (;;) {
+        if ((table_index < 0) || (table_index >= tables_.count())) {
+            DBMODEL_DEBUGM("Can't set row callback for column; index %d "
+                           "is out of valid range [0, %d) for tables\n",
+                           table_index, tables_.count());
+            break;
+        }
+
+        DbModelTbl & tbl = tables_[table_index];
+        b_ret = tbl.setRowCallback (column_index, value);
+        forgetCells ();
+
+        user_data_ = user_data;
+        break;
+    }
+    return b_ret;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+DbColRowKb DbModelPrivate::rowCallback (
+        int table_index, int column_index)
+{
+    if ((table_index < 0) || (table_index >= tables_.count()))
+        return NULL;
+    return tables_.at (table_index).rowCallback (column_index);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+DbColBatchKb DbModelPrivate::batchCallback (
+        int table_index, int column_index)
+{
+    if ((table_index < 0) || (table_index >= tables_.count()))
+        return NULL;
+    return tables_.at (table_index).batchCallback (column_index);
+}
+/* ========================================================================= */
+
 /*  CLASS    =============================================================== */
 //
 //
@@ -25,6 +25,9 @@
 
 #include <QAbstractTableModel>
 #include <QList>
+#include <QVector>
+#include <QCache>
+#include <QSet>
 
 #include <dbmodel/dbmodel-config.h>
 #include <dbmodel/dbmodelcol.h>
@@ -61,6 +64,9 @@
 #   define TMP_A(__s__) __s__.toLatin1 ().constData ()
 #endif
 
+//! Default number of values kept by the cache of DbModelPrivate::data().
+#define DBMODEL_CELL_CACHE 4096
+
 #ifndef BLACK_HOLE
 static inline void black_hole (...)
 {}
@@ -91,6 +97,24 @@ class DbModelPrivate : public QAbstractTableModel {
     //
     /*  DEFINITIONS    ----------------------------------------------------- */
 
+public:
+
+    //! Identifies a value in the cache of `data()`.
+    struct CellKey {
+        int row_; /**< the row */
+        int col_; /**< the column */
+        int role_; /**< the role */
+
+        CellKey (int row, int col, int role) :
+            row_(row), col_(col), role_(role) {}
+
+        bool operator== (const CellKey & other) const {
+            return (row_ == other.row_) &&
+                    (col_ == other.col_) &&
+                    (role_ == other.role_);
+        }
+    };
+
     /*  DEFINITIONS    ===================================================== */
     //
     //
@@ -105,6 +129,11 @@ private:
     int row_highlite_; /**< the row for the cell to highlite */
     int col_highlite_; /**< the column for the cell to highlite */
     void * user_data_; /**< data send along on column callbacks */
+    DbModelTbl::ForeignMode foreign_mode_; /**< how foreign values are retrieved */
+    bool columnar_; /**< main table keeps a typed copy of the rows */
+    mutable QCache<CellKey, QVariant> cells_; /**< most recently used
+                             values returned by `data()` */
+    mutable QSet<int> cell_roles_; /**< the roles present in `cells_` */
 
     /*  DATA    ============================================================ */
     //
@@ -272,10 +301,103 @@ public:
     record (
             int row) const;
 
+    //! A view of a row that reads the values in place.
+    DbModelRow
+    rowView (
+            int row) const;
+
+    //! Fill a buffer with the values of a block of cells.
+    bool
+    fetchBlock (
+            const QVector<int> & rows,
+            const QList<int> & columns,
+            int role,
+            QVector<QVariant> & values) const;
+
     //! Read the labels again (possibly in a different language).
     void
     reloadHeaders ();
 
+    //! Read the format settings of the columns again.
+    void
+    reloadFormats ();
+
+    //! Change the alignment of a column (invalid value for default).
+    bool
+    setColumnAlignment (
+            int column,
+            const QVariant & value);
+
+    //! How are the values for foreign columns retrieved.
+    DbModelTbl::ForeignMode
+    foreignMode () const {
+        return foreign_mode_;
+    }
+
+    //! Change the way values for foreign columns are retrieved.
+    void
+    setForeignMode (
+            DbModelTbl::ForeignMode value);
+
+    //! Maximum number of values kept by the cache of `data()`.
+    int
+    cellCacheSize () const {
+        return cells_.maxCost ();
+    }
+
+    //! Change the number of values kept by the cache of `data()`.
+    void
+    setCellCacheSize (
+            int value);
+
+    //! Forget the cached values for a range of rows (all if first is -1).
+    void
+    forgetCells (
+            int first,
+            int last) const;
+
+    //! Does the main table keep a typed copy of the rows?
+    bool
+    columnarStore () const {
+        return columnar_;
+    }
+
+    //! Read the rows of the main table from a typed copy.
+    void
+    setColumnarStore (
+            bool b_enable);
+
+    //! Change the way the rows of a secondary table are loaded.
+    bool
+    setLookupMode (
+            DbModelTbl::LookupMode value,
+            int table_index);
+
+    //! Change the way the rows of a secondary table are loaded.
+    bool
+    setLookupMode (
+            DbModelTbl::LookupMode value,
+            const QString & table);
+
+    //! Change when a secondary table is selected again.
+    bool
+    setRefreshPolicy (
+            DbModelTbl::RefreshPolicy value,
+            int table_index,
+            const QVariant & argument = QVariant ());
+
+    //! Change when a secondary table is selected again.
+    bool
+    setRefreshPolicy (
+            DbModelTbl::RefreshPolicy value,
+            const QString & table,
+            const QVariant & argument = QVariant ());
+
+    //! Select a table now, regardless of its refresh policy.
+    bool
+    refreshTable (
+            int table_index);
+
 
     /*  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  */
     /** @name QSqlTableModel
@@ -418,6 +540,30 @@ public:
         return user_data_;
     }
 
+    bool
+    setBatchCallback (
+            int table_index,
+            int column_index,
+            DbColBatchKb value,
+            void *user_data);
+
+    DbColBatchKb
+    batchCallback (
+            int table_index,
+            int column_index);
+
+    bool
+    setRowCallback (
+            int table_index,
+            int column_index,
+            DbColRowKb value,
+            void *user_data);
+
+    DbColRowKb
+    rowCallback (
+            int table_index,
+            int column_index);
+
     //! Find a table by name.
     const DbModelTbl &
     table (
@@ -439,6 +585,63 @@ private:
     void
     clearTables ();
 
+    //! Compute the value for a cell (`data()` without the cache).
+    QVariant
+    cellData (
+        const QModelIndex &idx,
+        int role) const;
+
+    //! Tell if the rows of a table are needed to present the data.
+    bool
+    isTableNeeded (
+            int table_index) const;
+
+    //! Rebuild the formats when the locale changes.
+    void
+    watchLocale ();
+
+    //! A secondary table was given another lookup.
+    void
+    lookupReplaced (
+            int table_index,
+            DbModelLookup * prev);
+
+signals:
+
+    //! A lookup used by secondary tables changed its content.
+    void
+    lookupChanged ();
+
+private slots:
+
+    //! The locale of the system changed.
+    void
+    localeChanged ();
+
+    //! An asynchronous secondary table loaded new rows.
+    void
+    lookupFetched ();
+
+    //! Forget all cached values.
+    void
+    forgetCells ();
+
+    //! Forget cached results for the rows that changed.
+    void
+    rowsChanged (
+            const QModelIndex & top_left,
+            const QModelIndex & bottom_right);
+
+    //! Values changed in the sql model of main table.
+    void
+    mainRowsChanged (
+            const QModelIndex & top_left,
+            const QModelIndex & bottom_right);
+
+    //! The sql model of main table was selected or reset.
+    void
+    mainReset ();
+
     /*  FUNCTIONS    ======================================================= */
     //
     //
@@ -447,6 +650,15 @@ private:
 public: virtual void anchorVtable() const;
 }; /* class DbModelPrivate */
 
+//! Hash for the keys of the cache of DbModelPrivate::data().
+inline uint qHash (const DbModelPrivate::CellKey & key)
+{
+    uint seed = qHash (key.row_);
+    seed ^= qHash (key.col_) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    seed ^= qHash (key.role_) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    return seed;
+}
+
 /*  CLASS    =============================================================== */
 //
 //
@@ -0,0 +1,124 @@
+/* ========================================================================= */
+/* ------------------------------------------------------------------------- */
+/*!
+  file         dbmodelrow.cc
+  date         October 2026
+  author       agent
+
+  brief        Contains the implementation for DbModelRow class.
+
+*//*
+
+ ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ Please read COPYING and README files in root folder
+ ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+/* ------------------------------------------------------------------------- */
+/* ========================================================================= */
+//
+//
+//
+//
+/*  INCLUDES    ------------------------------------------------------------ */
+
+#include "dbmodelrow.h"
+#include "dbmodeltbl.h"
+#include "dbmodelprivate.h"
+
+/*  INCLUDES    ============================================================ */
+//
+//
+//
+//
+/*  DEFINITIONS    --------------------------------------------------------- */
+
+/*  DEFINITIONS    ========================================================= */
+//
+//
+//
+//
+/*  CLASS    --------------------------------------------------------------- */
+
+/**
+ * @class DbModelRow
+ *
+ * Instances only store the table and the index of the row, so they are
+ * cheap to create and to copy; the values are read from the table
+ * (the columnar store, the sql model or the lookup) when they are
+ * requested. The fields are the columns of the sql model, the same ones
+ * a QSqlRecord for that row would have.
+ *
+ * A view is valid until the model is selected again or its table
+ * is changed; it should not be kept around.
+ */
+
+/* ------------------------------------------------------------------------- */
+bool DbModelRow::isValid () const
+{
+    return (table_ != NULL) && (row_ >= 0) && (row_ < table_->rowCount ());
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+int DbModelRow::count () const
+{
+    if (table_ == NULL)
+        return 0;
+    return table_->fieldCount ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+int DbModelRow::indexOf (const QString & name) const
+{
+    if (table_ == NULL)
+        return -1;
+    return table_->fieldIndex (name);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+QString DbModelRow::fieldName (int field) const
+{
+    if (table_ == NULL)
+        return QString ();
+    return table_->fieldName (field);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * @param field the index of the field (real index of the column)
+ * @return the value or an invalid variant if the index is out of bounds
+ */
+QVariant DbModelRow::value (int field) const
+{
+    if (!isValid () || (field < 0) || (field >= table_->fieldCount ()))
+        return QVariant ();
+    return table_->value (row_, field);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+QVariant DbModelRow::value (const QString & name) const
+{
+    return value (indexOf (name));
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+QSqlRecord DbModelRow::toRecord () const
+{
+    if (!isValid ())
+        return QSqlRecord ();
+    return table_->record (row_);
+}
+/* ========================================================================= */
+
+/*  CLASS    =============================================================== */
+//
+//
+//
+//
+/* ------------------------------------------------------------------------- */
+/* ========================================================================= */
@@ -0,0 +1,155 @@
+/* ========================================================================= */
+/* ------------------------------------------------------------------------- */
+/*!
+  file         dbmodelrow.h
+  date         October 2026
+  author       agent
+
+  brief        Contains the definition for DbModelRow class.
+
+*//*
+
+ ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ Please read COPYING and README files in root folder
+ ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+/* ------------------------------------------------------------------------- */
+/* ========================================================================= */
+#ifndef DBMODELROW_H
+#define DBMODELROW_H
+//
+//
+//
+//
+/*  INCLUDES    ------------------------------------------------------------ */
+
+#include <dbmodel/dbmodel-config.h>
+
+#include <QString>
+#include <QVariant>
+#include <QSqlRecord>
+
+/*  INCLUDES    ============================================================ */
+//
+//
+//
+//
+/*  DEFINITIONS    --------------------------------------------------------- */
+
+class DbModelTbl;
+
+/*  DEFINITIONS    ========================================================= */
+//
+//
+//
+//
+/*  CLASS    --------------------------------------------------------------- */
+
+//! A row in a table of the model, read in place.
+class DBMODEL_EXPORT DbModelRow
+{
+    //
+    //
+    //
+    //
+    /*  DEFINITIONS    ----------------------------------------------------- */
+
+    /*  DEFINITIONS    ===================================================== */
+    //
+    //
+    //
+    //
+    /*  DATA    ------------------------------------------------------------ */
+
+private:
+
+    const DbModelTbl * table_; /**< the table that holds the row */
+    int row_; /**< index of the row in the table */
+
+    /*  DATA    ============================================================ */
+    //
+    //
+    //
+    //
+    /*  FUNCTIONS    ------------------------------------------------------- */
+
+public:
+
+    //! Default constructor creates an invalid view.
+    DbModelRow () :
+        table_(NULL),
+        row_(-1)
+    {}
+
+    //! Constructor.
+    DbModelRow (
+            const DbModelTbl * table,
+            int row) :
+        table_(table),
+        row_(row)
+    {}
+
+    //! Tell if the view references a row.
+    bool
+    isValid () const;
+
+    //! The index of the row in the table.
+    int
+    row () const {
+        return row_;
+    }
+
+    //! Number of fields.
+    int
+    count () const;
+
+    //! The index of a field by its name (-1 if not found).
+    int
+    indexOf (
+            const QString & name) const;
+
+    //! The name of a field.
+    QString
+    fieldName (
+            int field) const;
+
+    //! The value of a field by its index.
+    QVariant
+    value (
+            int field) const;
+
+    //! The value of a field by its name.
+    QVariant
+    value (
+            const QString & name) const;
+
+    //! Tell if the value of a field is null.
+    bool
+    isNull (
+            int field) const {
+        return value (field).isNull ();
+    }
+
+    //! A copy of the row (for APIs that need a record).
+    QSqlRecord
+    toRecord () const;
+
+    /*  FUNCTIONS    ======================================================= */
+    //
+    //
+    //
+    //
+}; /* class DbModelRow */
+
+Q_DECLARE_TYPEINFO(DbModelRow, Q_MOVABLE_TYPE);
+
+/*  CLASS    =============================================================== */
+//
+//
+//
+//
+
+
+#endif // DBMODELROW_H
+/* ------------------------------------------------------------------------- */
+/* ========================================================================= */
@@ -0,0 +1,432 @@
+/* ========================================================================= */
+/* ------------------------------------------------------------------------- */
+/*!
+  file         dbmodelsortkeys.cc
+  date         October 2026
+  author       agent
+
+  brief        Contains the implementation for DbModelSortKeys class.
+
+*//*
+
+ ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ Please read COPYING and README files in root folder
+ ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+/* ------------------------------------------------------------------------- */
+/* ========================================================================= */
+//
+//
+//
+//
+/*  INCLUDES    ------------------------------------------------------------ */
+
+#include "dbmodelsortkeys.h"
+#include "dbmodelprivate.h"
+
+#include <QDateTime>
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+
+#include <algorithm>
+
+/*  INCLUDES    ============================================================ */
+//
+//
+//
+//
+/*  DEFINITIONS    --------------------------------------------------------- */
+
+//! Orders row indexes by their keys.
+struct DbModelSortLess {
+    const DbModelSortKeys * keys_;
+
+    DbModelSortLess (const DbModelSortKeys * keys) : keys_(keys) {}
+
+    bool operator() (int left_row, int right_row) const {
+        return keys_->keyLess (left_row, right_row);
+    }
+};
+
+//! Sorts a slice of the permutation on a worker thread.
+class DbModelSortChunk : public QRunnable {
+    DbModelSortLess less_;
+    int * first_;
+    int * last_;
+public:
+    DbModelSortChunk (const DbModelSortKeys * keys, int * first, int * last) :
+        less_(keys), first_(first), last_(last) {}
+    void run () {
+        std::stable_sort (first_, last_, less_);
+    }
+};
+
+//! Merges two adjacent sorted slices on a worker thread.
+class DbModelMergeChunk : public QRunnable {
+    DbModelSortLess less_;
+    const int * first_;
+    const int * middle_;
+    const int * last_;
+    int * out_;
+public:
+    DbModelMergeChunk (
+            const DbModelSortKeys * keys, const int * first,
+            const int * middle, const int * last, int * out) :
+        less_(keys), first_(first), middle_(middle), last_(last), out_(out) {}
+    void run () {
+        std::merge (first_, middle_, middle_, last_, out_, less_);
+    }
+};
+
+/*  DEFINITIONS    ========================================================= */
+//
+//
+//
+//
+/*  CLASS    --------------------------------------------------------------- */
+
+/**
+ * @class DbModelSortKeys
+ *
+ * DbModel builds the keys for the sort column before the proxy sorts
+ * the rows, so each value is read (and formatted, and looked up) once
+ * instead of twice for each comparison. The keys are indexed by the
+ * row in the source model and are only valid while that sort runs.
+ *
+ * Numbers, booleans, dates and times become numbers (dates and times
+ * are converted to the julian day, milliseconds since epoch or since
+ * midnight), anything else becomes text. Integers are kept as 64-bit
+ * integers (signed or unsigned), so ids above 2^53 keep their order.
+ * Null values sort first and numbers sort before texts.
+ *
+ * Texts are folded once if the case is ignored. When the texts are
+ * compared using the locale (and Qt provides QCollator) each text is
+ * replaced by its collation key, so comparing two texts no longer
+ * needs the locale.
+ *
+ * The rows are also sorted here, on the keys alone, and the proxy takes
+ * the result as its mapping (`sortedRows()`) instead of sorting again.
+ * Large tables are sorted on worker threads (slices sorted in parallel,
+ * then merged pairwise in parallel).
+ */
+
+/* ------------------------------------------------------------------------- */
+DbModelSortKeys::DbModelSortKeys () :
+    keys_(),
+    order_(),
+#if QT_VERSION >= QT_VERSION_CHECK(5, 2, 0)
+    collation_(),
+#endif
+    column_(-1),
+    role_(Qt::DisplayRole),
+    cs_(Qt::CaseSensitive),
+    locale_aware_(false)
+{
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * @param model the model that provides the values
+ * @param column the column to sort on
+ * @param role the role used to read the values
+ * @param cs are texts compared with case sensitivity?
+ * @param locale_aware are texts compared using the locale?
+ * @return false if the values could not be read
+ */
+bool DbModelSortKeys::build (
+        const DbModelPrivate * model, int column, int role,
+        Qt::CaseSensitivity cs, bool locale_aware)
+{
+    bool b_ret = false;
+    for (;;) {
+        clear ();
+        if ((model == NULL) || !model->isValid ())
+            break;
+
+        int row_count = model->rowCount ();
+        keys_.resize (row_count);
+        role_ = role;
+        cs_ = cs;
+        locale_aware_ = locale_aware;
+
+        // the collator deals with the case, the same way as the one
+        // in DbFlatProxy::lessThan(), so the keys and the values read
+        // for rows without a key sort in the same order
+#if QT_VERSION >= QT_VERSION_CHECK(5, 2, 0)
+        QCollator collator;
+        collator.setCaseSensitivity (cs);
+        Qt::CaseSensitivity key_cs = locale_aware ? Qt::CaseSensitive : cs;
+#else
+        Qt::CaseSensitivity key_cs = cs;
+#endif
+
+        QList<int> columns;
+        columns.append (column);
+        QVector<int> rows;
+        QVector<QVariant> values;
+        bool b_valid = true;
+        for (int first = 0; first < row_count; first += DBMODEL_SORT_BLOCK) {
+            int last = qMin (first + DBMODEL_SORT_BLOCK, row_count);
+            rows.resize (last - first);
+            for (int i = first; i < last; ++i) {
+                rows[i - first] = i;
+            }
+            if (!model->fetchBlock (rows, columns, role, values)) {
+                b_valid = false;
+                break;
+            }
+            for (int i = first; i < last; ++i) {
+                Key & key = keys_[i];
+                makeKey (values.at (i - first), key_cs, key);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 2, 0)
+                if (locale_aware && (key.kind_ == SK_TEXT)) {
+                    key.collate_ = collation_.count ();
+                    collation_.append (collator.sortKey (key.text_));
+                    key.text_.clear ();
+                }
+#endif
+            }
+        }
+        if (!b_valid) {
+            keys_.clear ();
+            break;
+        }
+
+        int threads = QThread::idealThreadCount ();
+        if (row_count < DBMODEL_SORT_PARALLEL)
+            threads = 1;
+        sortRows (qMax (threads, 1));
+
+        column_ = column;
+        b_ret = true;
+        break;
+    }
+    return b_ret;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void DbModelSortKeys::clear ()
+{
+    keys_.clear ();
+    order_.clear ();
+#if QT_VERSION >= QT_VERSION_CHECK(5, 2, 0)
+    collation_.clear ();
+#endif
+    column_ = -1;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * @param left_row row in the source model
+ * @param right_row row in the source model
+ * @return true if the key of the left row sorts before the one on the right
+ */
+bool DbModelSortKeys::keyLess (int left_row, int right_row) const
+{
+    const Key & left = keys_.at (left_row);
+    const Key & right = keys_.at (right_row);
+    bool b_left_nr = (left.kind_ > SK_NULL) && (left.kind_ < SK_TEXT);
+    bool b_right_nr = (right.kind_ > SK_NULL) && (right.kind_ < SK_TEXT);
+    if (b_left_nr && b_right_nr)
+        return numberLess (left, right);
+    if (left.kind_ != right.kind_)
+        return left.kind_ < right.kind_;
+
+    switch (left.kind_) {
+    case SK_TEXT:
+#if QT_VERSION >= QT_VERSION_CHECK(5, 2, 0)
+        if ((left.collate_ != -1) && (right.collate_ != -1))
+            return collation_.at (left.collate_).compare (
+                        collation_.at (right.collate_)) < 0;
+#endif
+        if (locale_aware_)
+            return QString::localeAwareCompare (left.text_, right.text_) < 0;
+        return left.text_ < right.text_;
+    default:
+        return false;
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The sort is stable, so rows with equal keys keep their order.
+ *
+ * @param threads number of slices sorted in parallel
+ */
+void DbModelSortKeys::sortRows (int threads)
+{
+    int row_count = keys_.count ();
+    QVector<int> perm (row_count);
+    for (int i = 0; i < row_count; ++i) {
+        perm[i] = i;
+    }
+    if (threads < 2) {
+        std::stable_sort (perm.begin (), perm.end (), DbModelSortLess (this));
+        order_ = perm;
+        return;
+    }
+    QVector<int> buffer (row_count);
+
+    QThreadPool pool;
+    pool.setMaxThreadCount (threads);
+
+    // sort the slices
+    int slice = (row_count + threads - 1) / threads;
+    int * data = perm.data ();
+    for (int first = 0; first < row_count; first += slice) {
+        int last = qMin (first + slice, row_count);
+        pool.start (new DbModelSortChunk (this, data + first, data + last));
+    }
+    pool.waitForDone ();
+
+    // merge adjacent slices until one is left
+    int * src = perm.data ();
+    int * dst = buffer.data ();
+    for (; slice < row_count; slice *= 2) {
+        for (int first = 0; first < row_count; first += 2 * slice) {
+            int middle = qMin (first + slice, row_count);
+            int last = qMin (first + 2 * slice, row_count);
+            pool.start (new DbModelMergeChunk (
+                            this, src + first, src + middle,
+                            src + last, dst + first));
+        }
+        pool.waitForDone ();
+        qSwap (src, dst);
+    }
+    order_ = src == perm.data () ? perm : buffer;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Rows with equal keys are in source order in both directions, as
+ * the stable sort of the proxy leaves them.
+ *
+ * @param order the direction
+ * @return the rows of the source model in sorted order
+ */
+QVector<int> DbModelSortKeys::sortedRows (Qt::SortOrder order) const
+{
+    if (order == Qt::AscendingOrder)
+        return order_;
+
+    // reverse the groups of equal keys, not the rows inside them
+    int row_count = order_.count ();
+    QVector<int> result;
+    result.reserve (row_count);
+    int end = row_count;
+    while (end > 0) {
+        int start = end - 1;
+        while ((start > 0) && !keyLess (order_.at (start - 1), order_.at (start)))
+            --start;
+        for (int i = start; i < end; ++i) {
+            result.append (order_.at (i));
+        }
+        end = start;
+    }
+    return result;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Integers are compared as integers, so large ids (above 2^53) keep
+ * their order; a column that mixes kinds compares through doubles.
+ *
+ * @param left a key of kind SK_NUMBER, SK_INTEGER or SK_UNSIGNED
+ * @param right a key of kind SK_NUMBER, SK_INTEGER or SK_UNSIGNED
+ * @return true if the left key sorts before the right one
+ */
+bool DbModelSortKeys::numberLess (const Key & left, const Key & right)
+{
+    if (left.kind_ == right.kind_) {
+        switch (left.kind_) {
+        case SK_INTEGER:
+            return left.integer_ < right.integer_;
+        case SK_UNSIGNED:
+            return left.unsigned_ < right.unsigned_;
+        default:
+            return left.number_ < right.number_;
+        }
+    }
+    if ((left.kind_ == SK_INTEGER) && (right.kind_ == SK_UNSIGNED)) {
+        return (left.integer_ < 0) ||
+                (static_cast<quint64>(left.integer_) < right.unsigned_);
+    }
+    if ((left.kind_ == SK_UNSIGNED) && (right.kind_ == SK_INTEGER)) {
+        return (right.integer_ >= 0) &&
+                (left.unsigned_ < static_cast<quint64>(right.integer_));
+    }
+
+    double d_left = left.kind_ == SK_INTEGER ?
+                static_cast<double>(left.integer_) :
+                (left.kind_ == SK_UNSIGNED ?
+                     static_cast<double>(left.unsigned_) : left.number_);
+    double d_right = right.kind_ == SK_INTEGER ?
+                static_cast<double>(right.integer_) :
+                (right.kind_ == SK_UNSIGNED ?
+                     static_cast<double>(right.unsigned_) : right.number_);
+    return d_left < d_right;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void DbModelSortKeys::makeKey (
+        const QVariant & value, Qt::CaseSensitivity cs, Key & key)
+{
+    key.integer_ = 0;
+    key.text_.clear ();
+    key.collate_ = -1;
+    if (value.isNull ()) {
+        key.kind_ = SK_NULL;
+        return;
+    }
+
+    key.kind_ = SK_INTEGER;
+    switch (value.type ()) {
+    case QVariant::Bool:
+    case QVariant::Int:
+    case QVariant::LongLong:
+        key.integer_ = value.toLongLong ();
+        break;
+    case QVariant::UInt:
+    case QVariant::ULongLong:
+        key.kind_ = SK_UNSIGNED;
+        key.unsigned_ = value.toULongLong ();
+        break;
+    case QVariant::Double:
+        key.kind_ = SK_NUMBER;
+        key.number_ = value.toDouble ();
+        break;
+    case QVariant::Date:
+        key.integer_ = value.toDate ().toJulianDay ();
+        break;
+    case QVariant::DateTime:
+        key.integer_ = value.toDateTime ().toMSecsSinceEpoch ();
+        break;
+    case QVariant::Time:
+        key.integer_ = QTime (0, 0).msecsTo (value.toTime ());
+        break;
+    default:
+        key.kind_ = SK_TEXT;
+        key.text_ = value.toString ();
+        if (cs == Qt::CaseInsensitive)
+            key.text_ = key.text_.toCaseFolded ();
+        break;
+    }
+}
+/* ========================================================================= */
+
+/*  CLASS    =============================================================== */
+//
+//
+//
+//
+void DbModelSortKeys::anchorVtable() const {}
+/* ------------------------------------------------------------------------- */
+/* ========================================================================= */
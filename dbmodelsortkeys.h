@@ -0,0 +1,217 @@
+/* ========================================================================= */
+/* ------------------------------------------------------------------------- */
+/*!
+  file         dbmodelsortkeys.h
+  date         October 2026
+  author       agent
+
+  brief        Contains the definition for DbModelSortKeys class.
+
+*//*
+
+ ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ Please read COPYING and README files in root folder
+ ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+/* ------------------------------------------------------------------------- */
+/* ========================================================================= */
+#ifndef DBMODELSORTKEYS_H
+#define DBMODELSORTKEYS_H
+//
+//
+//
+//
+/*  INCLUDES    ------------------------------------------------------------ */
+
+#include <dbmodel/dbmodel-config.h>
+
+#include <QVector>
+#include <QList>
+#include <QString>
+#include <QVariant>
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 2, 0)
+#   include <QCollator>
+#endif
+
+/*  INCLUDES    ============================================================ */
+//
+//
+//
+//
+/*  DEFINITIONS    --------------------------------------------------------- */
+
+class DbModelPrivate;
+
+//! Number of rows read at once while extracting the keys.
+#define DBMODEL_SORT_BLOCK 4096
+
+//! Smallest number of rows that are sorted on worker threads.
+#define DBMODEL_SORT_PARALLEL 32768
+
+/*  DEFINITIONS    ========================================================= */
+//
+//
+//
+//
+/*  CLASS    --------------------------------------------------------------- */
+
+//! The values of a column reduced to keys that are cheap to compare.
+class DbModelSortKeys {
+
+    //
+    //
+    //
+    //
+    /*  DEFINITIONS    ----------------------------------------------------- */
+
+    //! What part of a key is used.
+    enum Kind {
+        SK_NULL = 0, /**< no value; sorts first */
+        SK_NUMBER, /**< floating point numbers in `number_` */
+        SK_INTEGER, /**< signed integers, booleans, dates and times
+                         in `integer_` */
+        SK_UNSIGNED, /**< unsigned integers in `unsigned_` */
+        SK_TEXT /**< anything else, as text in `text_` or as collation key */
+    };
+
+    //! The key for one row.
+    struct Key {
+        Kind kind_; /**< what part of the key is used */
+        union {
+            double number_; /**< value for SK_NUMBER */
+            qint64 integer_; /**< value for SK_INTEGER (epoch for
+                                  dates and times) */
+            quint64 unsigned_; /**< value for SK_UNSIGNED */
+        };
+        QString text_; /**< text, folded if the case is ignored */
+        int collate_; /**< index in `collation_` (-1 to compare `text_`) */
+    };
+
+    /*  DEFINITIONS    ===================================================== */
+    //
+    //
+    //
+    //
+    /*  DATA    ------------------------------------------------------------ */
+
+    QVector<Key> keys_; /**< one key for each row of the source model */
+    QVector<int> order_; /**< the rows in ascending order of their keys
+                              (equal keys keep source order) */
+#if QT_VERSION >= QT_VERSION_CHECK(5, 2, 0)
+    QList<QCollatorSortKey> collation_; /**< collation keys for texts */
+#endif
+    int column_; /**< the column that provided the keys (-1 if none) */
+    int role_; /**< the role used to read the values */
+    Qt::CaseSensitivity cs_; /**< are texts compared with case sensitivity? */
+    bool locale_aware_; /**< compare texts using the locale */
+
+    /*  DATA    ============================================================ */
+    //
+    //
+    //
+    //
+    /*  FUNCTIONS    ------------------------------------------------------- */
+
+public:
+
+    //! Constructor.
+    DbModelSortKeys ();
+
+    //! destructor
+    virtual ~DbModelSortKeys () {}
+
+    //! Read the values of a column and compute the keys.
+    bool
+    build (
+            const DbModelPrivate * model,
+            int column,
+            int role,
+            Qt::CaseSensitivity cs,
+            bool locale_aware);
+
+    //! Forget the keys.
+    void
+    clear ();
+
+    //! Are there keys for this column?
+    bool
+    isValid (
+            int column) const {
+        return (column_ != -1) && (column_ == column);
+    }
+
+    //! Were the keys built for this column and these settings?
+    bool
+    matches (
+            int column,
+            int role,
+            Qt::CaseSensitivity cs,
+            bool locale_aware) const {
+        return isValid (column) && (role_ == role) &&
+                (cs_ == cs) && (locale_aware_ == locale_aware);
+    }
+
+    //! Number of keys.
+    int
+    count () const {
+        return keys_.count ();
+    }
+
+    //! Compare two rows.
+    bool
+    lessThan (
+            int left_row,
+            int right_row) const {
+        return keyLess (left_row, right_row);
+    }
+
+    //! The rows in sorted order.
+    QVector<int>
+    sortedRows (
+            Qt::SortOrder order) const;
+
+    //! Compare the keys of two rows.
+    bool
+    keyLess (
+            int left_row,
+            int right_row) const;
+
+private:
+
+    //! Sort the rows, on worker threads for large tables.
+    void
+    sortRows (
+            int threads);
+
+    //! Compare two keys that hold numbers of any kind.
+    static bool
+    numberLess (
+            const Key & left,
+            const Key & right);
+
+    //! Compute the key for a value.
+    static void
+    makeKey (
+            const QVariant & value,
+            Qt::CaseSensitivity cs,
+            Key & key);
+
+    /*  FUNCTIONS    ======================================================= */
+    //
+    //
+    //
+    //
+public: virtual void anchorVtable() const;
+}; /* class DbModelSortKeys */
+
+/*  CLASS    =============================================================== */
+//
+//
+//
+//
+
+
+#endif // DBMODELSORTKEYS_H
+/* ------------------------------------------------------------------------- */
+/* ========================================================================= */
@@ -0,0 +1,365 @@
+/* ========================================================================= */
+/* ------------------------------------------------------------------------- */
+/*!
+  file         dbmodelsql.cc
+  date         October 2026
+  author       agent
+
+  brief        Contains the implementation for DbModelSql class.
+
+*//*
+
+ ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ Please read COPYING and README files in root folder
+ ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+/* ------------------------------------------------------------------------- */
+/* ========================================================================= */
+//
+//
+//
+//
+/*  INCLUDES    ------------------------------------------------------------ */
+
+#include "dbmodelsql.h"
+#include "dbmodelprivate.h"
+
+#include <QSqlDatabase>
+#include <QSqlDriver>
+#include <QStringList>
+
+/*  INCLUDES    ============================================================ */
+//
+//
+//
+//
+/*  DEFINITIONS    --------------------------------------------------------- */
+
+//! The alias used for a joined table.
+static inline QString joinAlias (int index)
+{
+    return QString ("dbmj%1").arg (index);
+}
+
+//! The alias used for a column retrieved from a joined table.
+static inline QString fieldAlias (int index)
+{
+    return QString ("dbmj_f%1").arg (index);
+}
+
+//! The alias used for the secondary table in the sort subquery.
+#define DBMODEL_ORDER_ALIAS "dbmo"
+
+/*  DEFINITIONS    ========================================================= */
+//
+//
+//
+//
+/*  CLASS    --------------------------------------------------------------- */
+
+/**
+ * @class DbModelSql
+ *
+ * When the model is in DbModelTbl::FM_JOIN mode the values shown by
+ * foreign columns are retrieved by the main query: each secondary table
+ * is `LEFT JOIN`-ed to the main table and the display columns are
+ * appended after the columns of the main table. The columns of the main
+ * table keep their indexes, so the rest of the code is not affected.
+ *
+ * Without joins the model behaves exactly like a QSqlTableModel.
+ *
+ * The filter is inserted as is in the statement, so, when joins are
+ * present, the columns it uses should be qualified with the name of the
+ * main table if a secondary table has a column with same name.
+ *
+ * Foreign columns are sorted by the database on the value they show
+ * (`setForeignOrder()`): the ORDER BY clause uses the joined column
+ * if the secondary table is joined or a correlated subquery otherwise.
+ */
+
+/* ------------------------------------------------------------------------- */
+DbModelSql::DbModelSql (QObject * parent, QSqlDatabase db) :
+    QSqlTableModel (parent, db),
+    base_(),
+    joins_(),
+    fields_(),
+    order_local_(),
+    order_table_(),
+    order_key_(),
+    order_display_(),
+    order_dir_(Qt::AscendingOrder)
+{
+    DBMODEL_TRACE_ENTRY;
+    DBMODEL_TRACE_EXIT;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+DbModelSql::~DbModelSql()
+{
+    DBMODEL_TRACE_ENTRY;
+    DBMODEL_TRACE_EXIT;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * A secondary table is joined only once for each key column in main
+ * table, no matter how many columns are retrieved from it.
+ *
+ * The table must be set (`setTable()`) before calling this method.
+ * The change takes effect at next `select()`.
+ *
+ * @param local_col real index of the key column in main table
+ * @param table name of the secondary table
+ * @param key name of the key column in secondary table
+ * @param display name of the column to retrieve from secondary table
+ * @return the index of the column in this model or -1 on error
+ */
+int DbModelSql::addJoin (
+        int local_col, const QString & table,
+        const QString & key, const QString & display)
+{
+    int result = -1;
+    for (;;) {
+        if (base_.isEmpty ()) {
+            base_ = database ().record (tableName ());
+        }
+        if ((local_col < 0) || (local_col >= base_.count ())) {
+            DBMODEL_DEBUGM("Column %d is not a valid join key for %s\n",
+                           local_col, TMP_A(tableName ()));
+            break;
+        }
+
+        // find or create the join
+        int join_idx = -1;
+        int i_max = joins_.count ();
+        for (int i = 0; i < i_max; ++i) {
+            const Join & j = joins_.at (i);
+            if ((j.local_ == local_col) &&
+                    (j.table_ == table) &&
+                    (j.key_ == key)) {
+                join_idx = i;
+                break;
+            }
+        }
+        if (join_idx == -1) {
+            Join j;
+            j.local_ = local_col;
+            j.table_ = table;
+            j.key_ = key;
+            joins_.append (j);
+            join_idx = joins_.count () - 1;
+        }
+
+        // find or create the column
+        i_max = fields_.count ();
+        for (int i = 0; i < i_max; ++i) {
+            const Field & f = fields_.at (i);
+            if ((f.join_ == join_idx) && (f.column_ == display)) {
+                result = base_.count () + i;
+                break;
+            }
+        }
+        if (result == -1) {
+            Field f;
+            f.join_ = join_idx;
+            f.column_ = display;
+            fields_.append (f);
+            result = base_.count () + fields_.count () - 1;
+        }
+        break;
+    }
+    return result;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void DbModelSql::clearJoins ()
+{
+    joins_.clear ();
+    fields_.clear ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The change takes effect at next `select()`; sorting on a column
+ * of main table (`sort()`) should be preceded by `clearForeignOrder()`.
+ *
+ * @param local_cols real indexes of the key columns in main table
+ * @param table name of the secondary table
+ * @param keys names of the key columns in secondary table (same order
+ * as `local_cols`)
+ * @param display name of the column in secondary table to sort on
+ * @param order the direction
+ * @return false if the arguments are not valid
+ */
+bool DbModelSql::setForeignOrder (
+        const QList<int> & local_cols, const QString & table,
+        const QStringList & keys, const QString & display,
+        Qt::SortOrder order)
+{
+    bool b_ret = false;
+    for (;;) {
+        order_table_.clear ();
+        if (base_.isEmpty ()) {
+            base_ = database ().record (tableName ());
+        }
+        if (local_cols.isEmpty () || (local_cols.count () != keys.count ())) {
+            DBMODEL_DEBUGM("Keys don't match for sorting on table %s\n",
+                           TMP_A(table));
+            break;
+        }
+
+        QStringList local_names;
+        foreach(int col, local_cols) {
+            if ((col < 0) || (col >= base_.count ())) {
+                DBMODEL_DEBUGM("Column %d is not a valid key for %s\n",
+                               col, TMP_A(tableName ()));
+                break;
+            }
+            local_names.append (base_.fieldName (col));
+        }
+        if (local_names.count () != local_cols.count ())
+            break;
+
+        order_local_ = local_names;
+        order_table_ = table;
+        order_key_ = keys;
+        order_display_ = display;
+        order_dir_ = order;
+        b_ret = true;
+        break;
+    }
+    return b_ret;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+QString DbModelSql::orderByClause () const
+{
+    if (order_table_.isEmpty ())
+        return QSqlTableModel::orderByClause ();
+
+    QSqlDriver * driver = database ().driver ();
+    QString main_tbl = driver->escapeIdentifier (
+                tableName (), QSqlDriver::TableName);
+    QString display = driver->escapeIdentifier (
+                order_display_, QSqlDriver::FieldName);
+
+    // a joined table already provides the value
+    QString expr;
+    if (order_local_.count () == 1) {
+        int i_max = fields_.count ();
+        for (int i = 0; i < i_max; ++i) {
+            const Field & f = fields_.at (i);
+            const Join & j = joins_.at (f.join_);
+            if ((f.column_ == order_display_) &&
+                    (j.table_ == order_table_) &&
+                    (j.key_ == order_key_.first ()) &&
+                    (base_.fieldName (j.local_) == order_local_.first ())) {
+                expr = QString ("%1.%2").arg (joinAlias (f.join_)).arg (display);
+                break;
+            }
+        }
+    }
+
+    if (expr.isEmpty ()) {
+        QStringList conditions;
+        int i_max = order_local_.count ();
+        for (int i = 0; i < i_max; ++i) {
+            conditions.append (QString ("%1.%2 = %3.%4")
+                               .arg (DBMODEL_ORDER_ALIAS)
+                               .arg (driver->escapeIdentifier (
+                                         order_key_.at (i),
+                                         QSqlDriver::FieldName))
+                               .arg (main_tbl)
+                               .arg (driver->escapeIdentifier (
+                                         order_local_.at (i),
+                                         QSqlDriver::FieldName)));
+        }
+        expr = QString ("(SELECT %1.%2 FROM %3 %1 WHERE %4)")
+                .arg (DBMODEL_ORDER_ALIAS)
+                .arg (display)
+                .arg (driver->escapeIdentifier (
+                          order_table_, QSqlDriver::TableName))
+                .arg (conditions.join (" AND "));
+    }
+
+    return QString ("ORDER BY %1 %2")
+            .arg (expr)
+            .arg (order_dir_ == Qt::AscendingOrder ? "ASC" : "DESC");
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+QString DbModelSql::selectStatement () const
+{
+    if (joins_.isEmpty ())
+        return QSqlTableModel::selectStatement ();
+
+    QSqlDriver * driver = database ().driver ();
+    QString main_tbl = driver->escapeIdentifier (
+                tableName (), QSqlDriver::TableName);
+
+    // columns from main table, then columns from secondary tables
+    QStringList columns;
+    int i_max = base_.count ();
+    for (int i = 0; i < i_max; ++i) {
+        columns.append (QString ("%1.%2")
+                        .arg (main_tbl)
+                        .arg (driver->escapeIdentifier (
+                                  base_.fieldName (i),
+                                  QSqlDriver::FieldName)));
+    }
+    i_max = fields_.count ();
+    for (int i = 0; i < i_max; ++i) {
+        const Field & f = fields_.at (i);
+        columns.append (QString ("%1.%2 AS %3")
+                        .arg (joinAlias (f.join_))
+                        .arg (driver->escapeIdentifier (
+                                  f.column_, QSqlDriver::FieldName))
+                        .arg (fieldAlias (i)));
+    }
+
+    QString result = QString ("SELECT %1 FROM %2")
+            .arg (columns.join (", "))
+            .arg (main_tbl);
+
+    i_max = joins_.count ();
+    for (int i = 0; i < i_max; ++i) {
+        const Join & j = joins_.at (i);
+        result.append (QString (" LEFT JOIN %1 %2 ON %2.%3 = %4.%5")
+                       .arg (driver->escapeIdentifier (
+                                 j.table_, QSqlDriver::TableName))
+                       .arg (joinAlias (i))
+                       .arg (driver->escapeIdentifier (
+                                 j.key_, QSqlDriver::FieldName))
+                       .arg (main_tbl)
+                       .arg (driver->escapeIdentifier (
+                                 base_.fieldName (j.local_),
+                                 QSqlDriver::FieldName)));
+    }
+
+    if (!filter ().isEmpty ()) {
+        result.append (QString (" WHERE (%1)").arg (filter ()));
+    }
+
+    QString order = orderByClause ();
+    if (!order.isEmpty ()) {
+        result.append (" ").append (order);
+    }
+
+    return result;
+}
+/* ========================================================================= */
+
+/*  CLASS    =============================================================== */
+//
+//
+//
+//
+void DbModelSql::anchorVtable() const {}
+/* ------------------------------------------------------------------------- */
+/* ========================================================================= */
@@ -0,0 +1,164 @@
+/* ========================================================================= */
+/* ------------------------------------------------------------------------- */
+/*!
+  file         dbmodelsql.h
+  date         October 2026
+  author       agent
+
+  brief        Contains the definition for DbModelSql class.
+
+*//*
+
+ ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ Please read COPYING and README files in root folder
+ ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+/* ------------------------------------------------------------------------- */
+/* ========================================================================= */
+#ifndef DBMODELSQL_H
+#define DBMODELSQL_H
+//
+//
+//
+//
+/*  INCLUDES    ------------------------------------------------------------ */
+
+#include <dbmodel/dbmodel-config.h>
+
+#include <QSqlTableModel>
+#include <QSqlRecord>
+#include <QStringList>
+#include <QList>
+
+/*  INCLUDES    ============================================================ */
+//
+//
+//
+//
+/*  DEFINITIONS    --------------------------------------------------------- */
+
+/*  DEFINITIONS    ========================================================= */
+//
+//
+//
+//
+/*  CLASS    --------------------------------------------------------------- */
+
+//! The sql model used for main table.
+class DbModelSql : public QSqlTableModel {
+
+    //
+    //
+    //
+    //
+    /*  DEFINITIONS    ----------------------------------------------------- */
+
+    //! A secondary table joined to main table.
+    struct Join {
+        int local_; /**< real index of the key column in main table */
+        QString table_; /**< name of the secondary table */
+        QString key_; /**< name of the key column in secondary table */
+    };
+
+    //! A column retrieved from a secondary table.
+    struct Field {
+        int join_; /**< index of the join in `joins_` */
+        QString column_; /**< name of the column in secondary table */
+    };
+
+    /*  DEFINITIONS    ===================================================== */
+    //
+    //
+    //
+    //
+    /*  DATA    ------------------------------------------------------------ */
+
+    QSqlRecord base_; /**< the columns of the main table */
+    QList<Join> joins_; /**< secondary tables joined to main one */
+    QList<Field> fields_; /**< columns retrieved from secondary tables */
+    QStringList order_local_; /**< key columns in main table when sorting
+                                   on a secondary table */
+    QString order_table_; /**< secondary table that provides the values
+                               to sort on (empty to use the sort column) */
+    QStringList order_key_; /**< key columns in secondary table */
+    QString order_display_; /**< column in secondary table to sort on */
+    Qt::SortOrder order_dir_; /**< direction for sorting on a secondary table */
+
+    /*  DATA    ============================================================ */
+    //
+    //
+    //
+    //
+    /*  FUNCTIONS    ------------------------------------------------------- */
+
+public:
+
+    //! Constructor.
+    DbModelSql (
+            QObject * parent,
+            QSqlDatabase db);
+
+    //! destructor
+    virtual ~DbModelSql();
+
+    //! Retrieve a column from a secondary table along with main table.
+    int
+    addJoin (
+            int local_col,
+            const QString & table,
+            const QString & key,
+            const QString & display);
+
+    //! Remove all joins.
+    void
+    clearJoins ();
+
+    //! Number of joined secondary tables.
+    int
+    joinCount () const {
+        return joins_.count ();
+    }
+
+    //! Sort on a column of a secondary table.
+    bool
+    setForeignOrder (
+            const QList<int> & local_cols,
+            const QString & table,
+            const QStringList & keys,
+            const QString & display,
+            Qt::SortOrder order);
+
+    //! Sort on a column of main table again.
+    void
+    clearForeignOrder () {
+        order_table_.clear ();
+    }
+
+protected:
+
+    //! The ORDER BY clause of the statement.
+    virtual QString
+    orderByClause () const;
+
+    //! The statement used to retrieve the data.
+    virtual QString
+    selectStatement () const;
+
+    /*  FUNCTIONS    ======================================================= */
+    //
+    //
+    //
+    //
+public: virtual void anchorVtable() const;
+}; /* class DbModelSql */
+
+/*  CLASS    =============================================================== */
+//
+//
+//
+//
+
+
+#endif // DBMODELSQL_H
+/* ------------------------------------------------------------------------- */
+/* ========================================================================= */
@@ -0,0 +1,389 @@
+/* ========================================================================= */
+/* ------------------------------------------------------------------------- */
+/*!
+  file         dbmodelstore.cc
+  date         October 2026
+  author       agent
+
+  brief        Contains the implementation for DbModelStore class.
+
+*//*
+
+ ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ Please read COPYING and README files in root folder
+ ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+/* ------------------------------------------------------------------------- */
+/* ========================================================================= */
+//
+//
+//
+//
+/*  INCLUDES    ------------------------------------------------------------ */
+
+#include "dbmodelstore.h"
+#include "dbmodelprivate.h"
+
+#include <QSqlTableModel>
+#include <QSqlRecord>
+#include <QSqlField>
+#include <QDateTime>
+
+/*  INCLUDES    ============================================================ */
+//
+//
+//
+//
+/*  DEFINITIONS    --------------------------------------------------------- */
+
+/*  DEFINITIONS    ========================================================= */
+//
+//
+//
+//
+/*  CLASS    --------------------------------------------------------------- */
+
+/**
+ * @class DbModelStore
+ *
+ * Used by the main DbModelTbl when the columnar store is enabled
+ * (DbModel::setColumnarStore()). The rows that the sql model fetched are
+ * copied once into one vector for each column, based on the type
+ * reported by the driver: integers, reals, dates (as numbers) and strings
+ * (interned, so repeated values are stored once). Reads then avoid the
+ * cache of QSqlQueryModel and the values are only boxed in a QVariant
+ * when they are returned.
+ *
+ * Drivers may report a field type that is slightly different from the
+ * type of the values (SQLite reports integers but returns 64-bit
+ * integers), so the exact type is taken from the first value that is not
+ * null. A column that holds values of more than one type
+ * is stored as QVariant.
+ *
+ * The store does not fetch rows by itself, so the number of rows
+ * stays the same as the one reported by the model.
+ */
+
+/* ------------------------------------------------------------------------- */
+DbModelStore::DbModelStore () :
+    columns_(),
+    strings_(),
+    string_ids_(),
+    rows_(0),
+    loaded_(false)
+{
+    DBMODEL_TRACE_ENTRY;
+    DBMODEL_TRACE_EXIT;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void DbModelStore::clear ()
+{
+    columns_.clear ();
+    strings_.clear ();
+    string_ids_.clear ();
+    rows_ = 0;
+    loaded_ = false;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The kind of each column is decided from the type of the fields in
+ * the model.
+ *
+ * @param model the model to copy
+ */
+void DbModelStore::load (const QSqlTableModel * model)
+{
+    DBMODEL_TRACE_ENTRY;
+    clear ();
+    if (model == NULL)
+        return;
+
+    QSqlRecord structure = model->record ();
+    int i_max = structure.count ();
+    columns_.resize (i_max);
+    for (int i = 0; i < i_max; ++i) {
+        Column & column = columns_[i];
+        column.type_ = structure.field (i).type ();
+        column.typed_ = false;
+        column.spec_ = Qt::LocalTime;
+        column.kind_ = kindOf (column.type_);
+    }
+    loaded_ = true;
+
+    append (model);
+    DBMODEL_TRACE_EXIT;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * @param model the model to copy
+ */
+void DbModelStore::append (const QSqlTableModel * model)
+{
+    DBMODEL_TRACE_ENTRY;
+    if ((model == NULL) || !loaded_)
+        return;
+
+    int first = rows_;
+    int i_max = model->rowCount ();
+    if (i_max <= first)
+        return;
+    resize (i_max);
+
+    // rows_ only counts the rows that were copied
+    rows_ = first;
+    int j_max = columns_.count ();
+    for (int i = first; i < i_max; ++i) {
+        QSqlRecord rec = model->record (i);
+        for (int j = 0; j < j_max; ++j) {
+            setCell (columns_[j], i, rec.value (j));
+        }
+        rows_ = i + 1;
+    }
+    DBMODEL_TRACE_EXIT;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * @param model the model to copy
+ * @param row the row that changed
+ */
+void DbModelStore::reloadRow (const QSqlTableModel * model, int row)
+{
+    if ((model == NULL) || (row < 0) || (row >= rows_))
+        return;
+
+    QSqlRecord rec = model->record (row);
+    int j_max = columns_.count ();
+    for (int j = 0; j < j_max; ++j) {
+        setCell (columns_[j], row, rec.value (j));
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Null values are reported with the type of the column, same as
+ * the model does.
+ *
+ * @param row the index of the row (must be valid)
+ * @param col the real index of the column (must be valid)
+ * @return the value
+ */
+QVariant DbModelStore::value (int row, int col) const
+{
+    const Column & column = columns_.at (col);
+    if (column.kind_ == K_VARIANT)
+        return column.others_.at (row);
+    if (column.nulls_.testBit (row))
+        return QVariant (static_cast<QVariant::Type>(column.type_));
+
+    switch (column.kind_) {
+    case K_INTEGER: {
+        qint64 number = column.ints_.at (row);
+        switch (column.type_) {
+        case QVariant::Bool:
+            return QVariant (number != 0);
+        case QVariant::Int:
+            return QVariant (static_cast<int>(number));
+        case QVariant::UInt:
+            return QVariant (static_cast<uint>(number));
+        case QVariant::ULongLong:
+            return QVariant (static_cast<qulonglong>(number));
+        default:
+            return QVariant (static_cast<qlonglong>(number));
+        }
+    }
+    case K_REAL:
+        return QVariant (column.reals_.at (row));
+    case K_DATE:
+        return QVariant (QDate::fromJulianDay (column.ints_.at (row)));
+    case K_DATETIME:
+        return QVariant (QDateTime::fromMSecsSinceEpoch (
+                             column.ints_.at (row)).toTimeSpec (column.spec_));
+    case K_TIME:
+        return QVariant (QTime (0, 0).addMSecs (
+                             static_cast<int>(column.ints_.at (row))));
+    case K_STRING:
+        return QVariant (strings_.at (column.ints_.at (row)));
+    default:
+        return QVariant ();
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void DbModelStore::setCell (Column & column, int row, const QVariant & value)
+{
+    bool b_null = value.isNull ();
+    if (!b_null && (column.kind_ != K_VARIANT)) {
+        if (needsVariant (column, value)) {
+            demote (column, row);
+        } else if (!column.typed_) {
+            column.type_ = value.userType ();
+            if (column.kind_ == K_DATETIME) {
+                column.spec_ = value.toDateTime ().timeSpec ();
+            }
+        }
+    }
+    column.nulls_.setBit (row, b_null);
+    if (!b_null) {
+        column.typed_ = true;
+    }
+
+    switch (column.kind_) {
+    case K_VARIANT:
+        column.others_[row] = value;
+        break;
+    case K_INTEGER:
+        column.ints_[row] = b_null ? 0 : value.toLongLong ();
+        break;
+    case K_REAL:
+        column.reals_[row] = b_null ? 0.0 : value.toDouble ();
+        break;
+    case K_DATE:
+        column.ints_[row] = b_null ? 0 : value.toDate ().toJulianDay ();
+        break;
+    case K_DATETIME:
+        column.ints_[row] = b_null ? 0 : value.toDateTime ().toMSecsSinceEpoch ();
+        break;
+    case K_TIME:
+        column.ints_[row] = b_null ? 0 : QTime (0, 0).msecsTo (value.toTime ());
+        break;
+    case K_STRING:
+        column.ints_[row] = b_null ? 0 : intern (value.toString ());
+        break;
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The first value that is not null decides the exact type of a column
+ * (and the time spec for date-times). Only local and UTC times are
+ * stored as numbers, as other specs need more than the spec to be
+ * restored.
+ *
+ * @param column the column (not K_VARIANT)
+ * @param value a value that is not null
+ * @return true if the column must be stored as QVariant
+ */
+bool DbModelStore::needsVariant (
+        const Column & column, const QVariant & value) const
+{
+    if (column.typed_) {
+        if (value.userType () != column.type_)
+            return true;
+    } else if (kindOf (value.userType ()) != column.kind_) {
+        return true;
+    }
+    if (column.kind_ != K_DATETIME)
+        return false;
+
+    Qt::TimeSpec spec = value.toDateTime ().timeSpec ();
+    if ((spec != Qt::LocalTime) && (spec != Qt::UTC))
+        return true;
+    return column.typed_ && (spec != column.spec_);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+DbModelStore::Kind DbModelStore::kindOf (int type)
+{
+    switch (type) {
+    case QVariant::Bool:
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+        return K_INTEGER;
+    case QVariant::Double:
+        return K_REAL;
+    case QVariant::Date:
+        return K_DATE;
+    case QVariant::DateTime:
+        return K_DATETIME;
+    case QVariant::Time:
+        return K_TIME;
+    case QVariant::String:
+        return K_STRING;
+    default:
+        return K_VARIANT;
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Only the rows that were already copied hold values; the others
+ * (including `row`, that is about to be written) are left invalid.
+ *
+ * @param column the column to change
+ * @param row the row that is being written
+ */
+void DbModelStore::demote (Column & column, int row)
+{
+    int col = &column - columns_.constData ();
+    QVector<QVariant> others (column.nulls_.size ());
+    int i_max = qMin (rows_, others.count ());
+    for (int i = 0; i < i_max; ++i) {
+        if (i != row) {
+            others[i] = value (i, col);
+        }
+    }
+    column.others_ = others;
+    column.ints_.clear ();
+    column.reals_.clear ();
+    column.kind_ = K_VARIANT;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void DbModelStore::resize (int rows)
+{
+    int j_max = columns_.count ();
+    for (int j = 0; j < j_max; ++j) {
+        Column & column = columns_[j];
+        column.nulls_.resize (rows);
+        switch (column.kind_) {
+        case K_VARIANT:
+            column.others_.resize (rows);
+            break;
+        case K_REAL:
+            column.reals_.resize (rows);
+            break;
+        default:
+            column.ints_.resize (rows);
+        }
+    }
+    rows_ = rows;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+int DbModelStore::intern (const QString & value)
+{
+    QHash<QString, int>::const_iterator iter = string_ids_.constFind (value);
+    if (iter != string_ids_.constEnd ())
+        return iter.value ();
+    int result = strings_.count ();
+    strings_.append (value);
+    string_ids_.insert (value, result);
+    return result;
+}
+/* ========================================================================= */
+
+/*  CLASS    =============================================================== */
+//
+//
+//
+//
+void DbModelStore::anchorVtable() const {}
+/* ------------------------------------------------------------------------- */
+/* ========================================================================= */
@@ -0,0 +1,218 @@
+/* ========================================================================= */
+/* ------------------------------------------------------------------------- */
+/*!
+  file         dbmodelstore.h
+  date         October 2026
+  author       agent
+
+  brief        Contains the definition for DbModelStore class.
+
+*//*
+
+ ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ Please read COPYING and README files in root folder
+ ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+/* ------------------------------------------------------------------------- */
+/* ========================================================================= */
+#ifndef DBMODELSTORE_H
+#define DBMODELSTORE_H
+//
+//
+//
+//
+/*  INCLUDES    ------------------------------------------------------------ */
+
+#include <dbmodel/dbmodel-config.h>
+
+#include <QVector>
+#include <QHash>
+#include <QString>
+#include <QVariant>
+#include <QBitArray>
+
+/*  INCLUDES    ============================================================ */
+//
+//
+//
+//
+/*  DEFINITIONS    --------------------------------------------------------- */
+
+QT_BEGIN_NAMESPACE
+class QSqlTableModel;
+QT_END_NAMESPACE
+
+/*  DEFINITIONS    ========================================================= */
+//
+//
+//
+//
+/*  CLASS    --------------------------------------------------------------- */
+
+//! Typed, column-oriented copy of the rows in a sql model.
+class DbModelStore {
+
+    //
+    //
+    //
+    //
+    /*  DEFINITIONS    ----------------------------------------------------- */
+
+    //! How are the values in a column stored.
+    enum Kind {
+        K_INTEGER = 0, /**< integers and booleans in `ints_` */
+        K_REAL, /**< floating point values in `reals_` */
+        K_DATE, /**< julian day in `ints_` */
+        K_DATETIME, /**< milliseconds since epoch in `ints_`, all values
+                         with the time spec in `spec_` */
+        K_TIME, /**< milliseconds since midnight in `ints_` */
+        K_STRING, /**< id of the interned string in `ints_` */
+        K_VARIANT /**< anything else, in `others_` */
+    };
+
+    //! The values in a column.
+    struct Column {
+        Kind kind_; /**< how the values are stored */
+        int type_; /**< the type of the values */
+        bool typed_; /**< `type_` comes from a value, not from the field */
+        Qt::TimeSpec spec_; /**< time spec of the values for K_DATETIME */
+        QVector<qint64> ints_; /**< values for integer-like kinds */
+        QVector<double> reals_; /**< values for K_REAL */
+        QVector<QVariant> others_; /**< values for K_VARIANT */
+        QBitArray nulls_; /**< one bit for each null value */
+    };
+
+    /*  DEFINITIONS    ===================================================== */
+    //
+    //
+    //
+    //
+    /*  DATA    ------------------------------------------------------------ */
+
+    QVector<Column> columns_; /**< one entry for each (real) column */
+    QVector<QString> strings_; /**< interned strings */
+    QHash<QString, int> string_ids_; /**< id of each interned string */
+    int rows_; /**< number of rows copied so far */
+    bool loaded_; /**< the columns were created */
+
+    /*  DATA    ============================================================ */
+    //
+    //
+    //
+    //
+    /*  FUNCTIONS    ------------------------------------------------------- */
+
+public:
+
+    //! Constructor.
+    DbModelStore ();
+
+    //! destructor
+    virtual ~DbModelStore () {}
+
+    //! Forget all the values.
+    void
+    clear ();
+
+    //! Were the rows copied since last `clear()`?
+    bool
+    isLoaded () const {
+        return loaded_;
+    }
+
+    //! Number of rows copied so far.
+    int
+    rowCount () const {
+        return rows_;
+    }
+
+    //! Number of columns.
+    int
+    columnCount () const {
+        return columns_.count ();
+    }
+
+    //! Copy all the rows that the model fetched.
+    void
+    load (
+            const QSqlTableModel * model);
+
+    //! Copy the rows that the model fetched since last call.
+    void
+    append (
+            const QSqlTableModel * model);
+
+    //! Copy a row again (its values changed).
+    void
+    reloadRow (
+            const QSqlTableModel * model,
+            int row);
+
+    //! The value in a cell, as the model would report it.
+    QVariant
+    value (
+            int row,
+            int col) const;
+
+    //! Tell if the value in a cell is null.
+    bool
+    isNull (
+            int row,
+            int col) const {
+        return columns_.at (col).nulls_.testBit (row);
+    }
+
+private:
+
+    //! Store a value in a cell.
+    void
+    setCell (
+            Column & column,
+            int row,
+            const QVariant & value);
+
+    //! Tell if a value can't be stored with the kind of the column.
+    bool
+    needsVariant (
+            const Column & column,
+            const QVariant & value) const;
+
+    //! The kind used to store the values of a type.
+    static Kind
+    kindOf (
+            int type);
+
+    //! Change the storage of a column to K_VARIANT.
+    void
+    demote (
+            Column & column,
+            int row);
+
+    //! Make room for a number of rows in all columns.
+    void
+    resize (
+            int rows);
+
+    //! Get the id of a string, adding it if needed.
+    int
+    intern (
+            const QString & value);
+
+    /*  FUNCTIONS    ======================================================= */
+    //
+    //
+    //
+    //
+public: virtual void anchorVtable() const;
+}; /* class DbModelStore */
+
+/*  CLASS    =============================================================== */
+//
+//
+//
+//
+
+
+#endif // DBMODELSTORE_H
+/* ------------------------------------------------------------------------- */
+/* ========================================================================= */
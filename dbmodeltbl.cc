@@ -23,9 +23,14 @@
 
 #include "dbmodelprivate.h"
 #include "dbmodeltbl.h"
+#include "dbmodellookup.h"
+#include "dbmodelmanager.h"
+#include "dbmodelsql.h"
+#include "dbmodelstore.h"
 
 #include <QSqlTableModel>
 #include <QSqlRecord>
+#include <QColor>
 
 /*  INCLUDES    ============================================================ */
 //
@@ -34,6 +39,26 @@
 //
 /*  DEFINITIONS    --------------------------------------------------------- */
 
+//! Marks a row in RowCache that was not resolved, yet.
+#define DBMODEL_ROW_UNRESOLVED (-2)
+
+//! Number of rows computed by one call to a batch callback.
+#define DBMODEL_DYNAMIC_BATCH 64
+
+//! Tell if a column holds integers (can use the faster index).
+static bool isIntegerColumn (const DbColumn & col)
+{
+    switch (col.columnType ()) {
+    case DbDataType::DTY_TINYINT:
+    case DbDataType::DTY_SMALLINT:
+    case DbDataType::DTY_INTEGER:
+    case DbDataType::DTY_BIGINT:
+        return true;
+    default:
+        return false;
+    }
+}
+
 /*  DEFINITIONS    ========================================================= */
 //
 //
@@ -55,7 +80,20 @@
 DbModelTbl::DbModelTbl ()  :
     meta_(NULL),
     model_(NULL),
-    mapping_()
+    mapping_(),
+    lookup_(NULL),
+    resolved_(),
+    styles_(),
+    nulls_(),
+    waiting_first_(-1),
+    waiting_last_(-1),
+    store_(NULL),
+    dynamic_(),
+    accessors_(),
+    field_names_(),
+    field_index_(),
+    order_col_(-1),
+    order_dir_(Qt::AscendingOrder)
 {
 }
 /* ========================================================================= */
@@ -65,7 +103,20 @@ DbModelTbl::DbModelTbl (
         DbTaew * meta_part, QSqlTableModel * model_part) :
     meta_(meta_part),
     model_(model_part),
-    mapping_()
+    mapping_(),
+    lookup_(NULL),
+    resolved_(),
+    styles_(),
+    nulls_(),
+    waiting_first_(-1),
+    waiting_last_(-1),
+    store_(NULL),
+    dynamic_(),
+    accessors_(),
+    field_names_(),
+    field_index_(),
+    order_col_(-1),
+    order_dir_(Qt::AscendingOrder)
 {
 }
 /* ========================================================================= */
@@ -115,6 +166,7 @@ bool DbModelTbl::setColumnCallback (int column_index, DbColKb value)
         }
 
         b_ret = mapping_[column_index].setColumnCallback (value);
+        clearDynamic ();
         break;
     }
     return b_ret;
@@ -146,6 +198,66 @@ DbColKb DbModelTbl::columnCallback (int column_index) const
 }
 /* ========================================================================= */
 
+/* ------------------------------------------------------------------------- */
+bool DbModelTbl::setBatchCallback (int column_index, DbColBatchKb value)
+{
+    bool b_ret = false;
+    for (;;) {
+
+        if ((column_index < 0) || (column_index >= columnCount ())) {
+            DBMODEL_DEBUGM("Can't set batch callback for column; index %d "
+                           "is out of valid range [0, %d) for columns\n",
+                           column_index, columnCount());
+            break;
+        }
+
+        b_ret = mapping_[column_index].setBatchCallback (value);
+        clearDynamic ();
+        break;
+    }
+    return b_ret;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+DbColBatchKb DbModelTbl::batchCallback (int column_index) const
+{
+    if ((column_index < 0) || (column_index >= columnCount ()))
+        return NULL;
+    return mapping_.at (column_index).batchCallback ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+bool DbModelTbl::setRowCallback (int column_index, DbColRowKb value)
+{
+    bool b_ret = false;
+    for (;;) {
+
+        if ((column_index < 0) || (column_index >= columnCount ())) {
+            DBMODEL_DEBUGM("Can't set row callback for column; index %d "
+                           "is out of valid range [0, %d) for columns\n",
+                           column_index, columnCount());
+            break;
+        }
+
+        b_ret = mapping_[column_index].setRowCallback (value);
+        clearDynamic ();
+        break;
+    }
+    return b_ret;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+DbColRowKb DbModelTbl::rowCallback (int column_index) const
+{
+    if ((column_index < 0) || (column_index >= columnCount ()))
+        return NULL;
+    return mapping_.at (column_index).rowCallback ();
+}
+/* ========================================================================= */
+
 /* ------------------------------------------------------------------------- */
 /**
  * @return number of columns
@@ -159,6 +271,8 @@ int DbModelTbl::columnCount () const
 /* ------------------------------------------------------------------------- */
 int DbModelTbl::rowCount() const
 {
+    if (lookup_ != NULL)
+        return lookup_->rowCount ();
     if (model_ == NULL)
         return 0;
     return model_->rowCount ();
@@ -166,252 +280,1130 @@ int DbModelTbl::rowCount() const
 /* ========================================================================= */
 
 /* ------------------------------------------------------------------------- */
-void DbModelTbl::destroy ()
+/**
+ * Secondary tables in on-demand mode do not keep their rows in the
+ * sql model, so all reads go through this method and `record()`.
+ *
+ * With a columnar store the rows are copied the first time they are
+ * read; rows fetched later by the sql model are appended on demand.
+ *
+ * @param row the index of the row
+ * @param col the real index of the column
+ * @return the raw (edit role) value
+ */
+QVariant DbModelTbl::value (int row, int col) const
 {
-    if (meta_ != NULL) {
-        delete meta_;
-        meta_ = NULL;
+    if (lookup_ != NULL)
+        return lookup_->value (row, col);
+    if (store_ != NULL) {
+        if (!store_->isLoaded ()) {
+            store_->load (model_);
+        } else if (row >= store_->rowCount ()) {
+            store_->append (model_);
+        }
+        if ((row >= 0) && (row < store_->rowCount ()) &&
+                (col >= 0) && (col < store_->columnCount ())) {
+            return store_->value (row, col);
+        }
     }
-    if (model_ != NULL) {
-        model_->deleteLater ();
-        model_ = NULL;
+    return model_->index (row, col).data (Qt::EditRole);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The structure of the sql model does not change once the table
+ * is set (except for the joins, which clear the names), so the names
+ * are read once.
+ */
+void DbModelTbl::loadFields () const
+{
+    if (!field_names_.isEmpty ())
+        return;
+    QSqlTableModel * model = lookup_ != NULL ? lookup_->sqlModel () : model_;
+    if (model == NULL)
+        return;
+    QSqlRecord structure = model->record ();
+    int i_max = structure.count ();
+    for (int i = 0; i < i_max; ++i) {
+        QString name = structure.fieldName (i);
+        field_names_.append (name);
+        field_index_.insert (name, i);
     }
-    mapping_.clear();
 }
 /* ========================================================================= */
 
 /* ------------------------------------------------------------------------- */
-bool DbModelTbl::setHeaderData (int section, Qt::Orientation orientation, const QVariant &value, int role)
+int DbModelTbl::fieldCount () const
 {
-    if (orientation != Qt::Horizontal || section < 0 || columnCount() <= section)
-        return false;
-    if (role != Qt::DisplayRole)
-        if (role != Qt::EditRole)
-            return false;
+    loadFields ();
+    return field_names_.count ();
+}
+/* ========================================================================= */
 
-    DbModelCol & col = mapping_[section];
-    col.label_ = value.toString ();
-    return true;
+/* ------------------------------------------------------------------------- */
+int DbModelTbl::fieldIndex (const QString & name) const
+{
+    loadFields ();
+    return field_index_.value (name, -1);
 }
 /* ========================================================================= */
 
 /* ------------------------------------------------------------------------- */
-QVariant DbModelTbl::getRemoteData (
-        const DbModelPrivate* mp, int kcol, int dcol,
-        const QVariant &key) const
+QString DbModelTbl::fieldName (int field) const
 {
-    QVariant result;
+    loadFields ();
+    if ((field < 0) || (field >= field_names_.count ()))
+        return QString ();
+    return field_names_.at (field);
+}
+/* ========================================================================= */
 
-    if (model_ != NULL) {
-        int i_max = model_->rowCount ();
-        for (int i = 0; i < i_max; ++i) {
-            // loop-get the key
-            QVariant iter_key =
-                    model_->index (i, kcol)
-                    .data (Qt::EditRole);
-            // did we found it? (inefficient)
-            if (iter_key == key) {
-                const DbModelCol & column = mapping_.at (dcol);
-                const DbColumn & col_meta = column.original_;
-
-                int role = Qt::EditRole;
-                if (col_meta.isDynamic() || col_meta.isForeignKey ())
-                    role = Qt::DisplayRole;
-                result = data (
-                            mp, i, dcol, role);
-                break;
-            }
+/* ------------------------------------------------------------------------- */
+/**
+ * Only the main table may use a columnar store; secondary tables
+ * keep their rows in DbModelLookup.
+ *
+ * @param b_enable true to copy the rows, false to read the sql model
+ */
+void DbModelTbl::setColumnarStore (bool b_enable)
+{
+    if (b_enable) {
+        if ((store_ == NULL) && (lookup_ == NULL)) {
+            store_ = new DbModelStore ();
         }
+    } else if (store_ != NULL) {
+        delete store_;
+        store_ = NULL;
     }
+}
+/* ========================================================================= */
 
-    return result;
+/* ------------------------------------------------------------------------- */
+QSqlRecord DbModelTbl::record (int row) const
+{
+    if (lookup_ != NULL)
+        return lookup_->record (row);
+    return model_->record (row);
 }
 /* ========================================================================= */
 
 /* ------------------------------------------------------------------------- */
-QVariant DbModelTbl::data (
-        const DbModelPrivate* mp, int row, int col, int role) const
+/**
+ * Virtual foreign columns do not store the key; they use the
+ * key stored by the column they reference.
+ *
+ * @param column a foreign column in this table
+ * @return the real index of the column that stores the key
+ */
+int DbModelTbl::keyRealIndex (const DbModelCol & column) const
 {
-#ifdef DBMODEL_DEBUG
-    if (col == 6) {
-        if (role == Qt::DisplayRole) {
-            int kkk = 0;
-        }
+    if (column.original_.isVirtual ()) {
+        assert(column.original_.virtrefcol_ >= 0);
+        assert(column.original_.virtrefcol_ < columnCount ());
+        return mapping_.at (
+                    column.original_.virtrefcol_).mainTableRealIndex ();
     }
+    return column.mainTableRealIndex ();
+}
+/* ========================================================================= */
 
-#endif
+/* ------------------------------------------------------------------------- */
+/**
+ * @param row the row in this table
+ * @param column a foreign column in this table
+ * @return the value in the key column or, for composite keys, the list
+ * of values in all key columns
+ */
+QVariant DbModelTbl::keyValue (int row, const DbModelCol & column) const
+{
+    const DbModelCol & owner = column.original_.isVirtual () ?
+                mapping_.at (column.original_.virtrefcol_) : column;
+    if (owner.local_keys_.isEmpty ())
+        return value (row, keyRealIndex (column));
 
-    QVariant result;
-    for (;;) {
-        if (!isColIndexValid (col)) {
-            break;
-        }
+    QVariantList result;
+    foreach(int col, owner.local_keys_) {
+        result.append (value (row, col));
+    }
+    return result;
+}
+/* ========================================================================= */
 
-        // Degenerate case.
-        if (model_ == NULL) {
-            break;
-        }
+/* ------------------------------------------------------------------------- */
+/**
+ * Called when the key in a row was not yet seen by an on-demand
+ * secondary table. The keys in the next DBMODEL_ONDEMAND_BATCH rows
+ * (the ones most likely to be displayed next) are collected and
+ * loaded with a single query. Asynchronous tables queue the
+ * keys for the worker thread instead.
+ *
+ * @param row the row that needs the key
+ * @param column the foreign column that needs the key
+ */
+void DbModelTbl::fetchRemoteKeys (int row, const DbModelCol & column) const
+{
+    DBMODEL_TRACE_ENTRY;
+    DbModelLookup * lookup = column.table_->lookup ();
+    int i_max = qMin (rowCount (), row + DBMODEL_ONDEMAND_BATCH);
 
-        const DbModelCol & column = mapping_.at (col);
-        const DbColumn & col_meta = column.original_;
+    QList<QVariant> keys;
+    for (int i = row; i < i_max; ++i) {
+        keys.append (keyValue (i, column));
+    }
+    if (lookup->isAsync ()) {
+        lookup->request (column.t_key_, keys);
+    } else {
+        lookup->fetch (column.t_key_, keys);
+    }
+    DBMODEL_TRACE_EXIT;
+}
+/* ========================================================================= */
 
-        if (col_meta.isDynamic ()) {
-            QSqlRecord rec = model_->record (row);
-            result = column.original_.kbData (*meta_,
-                                            rec,
-                                            role,
-                                            mp->parentDbModel ());
+/* ------------------------------------------------------------------------- */
+/**
+ * A lookup with the new mode is acquired from DbModelManager and
+ * replaces current one. Has no effect on main table.
+ *
+ * @param db the database that holds the table
+ * @param mode the new mode
+ * @return false if a new lookup could not be created
+ */
+bool DbModelTbl::setLookupMode (DbStruct * db, LookupMode mode)
+{
+    bool b_ret = false;
+    for (;;) {
+        if (lookup_ == NULL) {
+            DBMODEL_DEBUGM("Lookup mode can only be set for secondary tables\n");
             break;
-        } else {
-            // We only service these roles from hereon now.
-            if (role != Qt::DisplayRole)
-                if (role != Qt::EditRole)
-                    break;
-
-            if (col_meta.isVirtual ()) {
-                // if this is a virtual column we need the index of the original column
-                assert(col_meta.virtrefcol_ >= 0);
-                assert(col_meta.virtrefcol_ < columnCount ());
-                // get the key in foreign table
-                const DbModelCol & ref_col = columnData (col_meta.virtrefcol_);
-                result = model_->index (
-                            row, ref_col.mainTableRealIndex ())
-                        .data (Qt::EditRole);
-            } else {
-                // Get the value stored on this column (may be actual
-                // value or the key in a foreign table.
-                result = model_->index (
-                            row, column.mainTableRealIndex ())
-                        .data (Qt::EditRole);
-            }
         }
-
-        // For edit role we return raw data.
-        if (role == Qt::EditRole) {
+        if (lookup_->mode () == mode) {
+            b_ret = true;
             break;
         }
 
-        // If the column is not foreign we have the result.
-        if (!column.isForeign ()) {
-            result = col_meta.formattedData (result);
+        DbModelLookup * other = DbModelManager::acquireLookup (
+                    db, meta_, lookup_->isShared (), mode);
+        if (other == NULL) {
+            DBMODEL_DEBUGM("Can't create lookup for table %s\n",
+                           TMP_A(tableName ()));
             break;
         }
 
-        result = column.table_->getRemoteData (
-                    mp, column.t_primary_, column.t_display_, result);
-        if (result.isNull())
-            break;
-        result = column.table_->column (column.t_display_).
-                formattedData (result);
-#if 0
-        // we have a value that is an index in another table
-        QSqlTableModel * model = column.table_->sqlModel ();
-        if (model == NULL)
-            break;
-
-        int i_max = model->rowCount ();
-        for (int i = 0; i < i_max; ++i) {
-            // loop-get the key
-            QVariant iter_key =
-                    model->index (i, column.t_primary_)
-                    .data (Qt::EditRole);
-            // did we found it? (inefficient)
-            if (iter_key == result) {
-                result = column.table_->data (
-                            mp, i, column.t_display_, Qt::EditRole);
-//                result = model->index (i, column.t_display_)
-//                        .data (Qt::DisplayRole);
-
-                // format the data according to the rules for source column
-                result = column.table_->column (column.t_display_).formattedData (
-                            result);
-                break;
-            }
-        }
-#endif
+        replaceLookup (other);
+        b_ret = true;
         break;
     }
-    return result;
+    return b_ret;
 }
 /* ========================================================================= */
 
 /* ------------------------------------------------------------------------- */
-const DbModelCol &DbModelTbl::columnData(int index) const
+DbModelTbl::RefreshPolicy DbModelTbl::refreshPolicy () const
 {
-    return mapping_.at (index);
+    if (lookup_ == NULL)
+        return RP_ALWAYS;
+    return lookup_->refreshPolicy ();
 }
 /* ========================================================================= */
 
 /* ------------------------------------------------------------------------- */
-int DbModelTbl::toRealIndex (int value) const
+/**
+ * The policy belongs to the lookup, so it applies to all the models
+ * that share this secondary table; it is carried over when the table
+ * gets another lookup. The main table is always selected.
+ *
+ * @param value the new policy
+ * @param argument the number of milliseconds for RP_TTL; the statement
+ * that retrieves the version (a single value) for RP_VERSION
+ * @return false if this is the main table or the argument is not valid
+ */
+bool DbModelTbl::setRefreshPolicy (
+        RefreshPolicy value, const QVariant & argument)
 {
-    if (meta_ == NULL) {
-        return NULL;
+    bool b_ret = false;
+    for (;;) {
+        if (lookup_ == NULL) {
+            DBMODEL_DEBUGM("Refresh policy can only be set for secondary tables\n");
+            break;
+        }
+
+        b_ret = lookup_->setRefreshPolicy (value, argument);
+        break;
     }
-    return meta_->toRealIndex (value);
+    return b_ret;
 }
 /* ========================================================================= */
 
 /* ------------------------------------------------------------------------- */
-void DbModelTbl::constructColumns (DbModelPrivate* mp)
+DbModelTbl::LookupMode DbModelTbl::lookupMode () const
 {
-    mapping_.clear();
-    if (meta_ == NULL)
-        return;
-
-    int i_max = meta_->columnCount ();
-
-    // There's going to be at least this many columns.
-    mapping_.reserve (i_max);
+    if (lookup_ == NULL)
+        return LM_FULL;
+    return lookup_->mode ();
+}
+/* ========================================================================= */
 
-    // create the columns as we go
-    int col_idx = 0;
-    for (int i = 0; i < i_max; ++i) {
-        DbColumn col = meta_->columnCtor (i);
-        if (col.isForeignKey ()) {
-            addForeignKeyColumn (col, col_idx, mp);
-        } else {
-            DbModelCol loc_col (col, col_idx, *this);
-            loc_col.t_display_ = col.columnId ();
-//            loc_col.t_display_ = col.columnRealId();
-            if (loc_col.t_display_  == -1) {
-                DBMODEL_DEBUGM("Cannot use virtual column as display "
-                               "(column %s - %d)\n",
-                               TMP_A(col.columnName()), i);
-                continue;
-            }
-            loc_col.label_ = loc_col.original_.columnLabel ();
-            //setHeaderData(col_idx, Qt::Vertical, QString("X %1").arg (col_idx));
-            mapping_.append (loc_col);
-            ++col_idx;
-        }
+/* ------------------------------------------------------------------------- */
+void DbModelTbl::destroy ()
+{
+    if (meta_ != NULL) {
+        delete meta_;
+        meta_ = NULL;
     }
+    if (lookup_ != NULL) {
+        DbModelManager::releaseLookup (lookup_);
+        lookup_ = NULL;
+        model_ = NULL;
+    } else if (model_ != NULL) {
+        model_->deleteLater ();
+        model_ = NULL;
+    }
+    if (store_ != NULL) {
+        delete store_;
+        store_ = NULL;
+    }
+    mapping_.clear();
+    styles_.clear();
+    resolved_.clear();
+    nulls_.clear();
+    dynamic_.clear();
+    accessors_.clear();
+    field_names_.clear();
+    field_index_.clear();
+    waiting_first_ = -1;
+    waiting_last_ = -1;
+    order_col_ = -1;
 }
 /* ========================================================================= */
 
 /* ------------------------------------------------------------------------- */
-void DbModelTbl::addForeignKeyColumn (
-        const DbColumn & col, int & col_idx, DbModelPrivate* mp)
+bool DbModelTbl::setHeaderData (int section, Qt::Orientation orientation, const QVariant &value, int role)
 {
-    DBMODEL_TRACE_ENTRY;
+    if (orientation != Qt::Horizontal || section < 0 || columnCount() <= section)
+        return false;
+    if (role != Qt::DisplayRole)
+        if (role != Qt::EditRole)
+            return false;
 
-    // attempt to locate the secondary table in the database
-    const DbModelTbl & secondary = mp->table (col.foreign_table_);
-    int key_col = -1;
-    if (secondary.isValid()) {
-        key_col = secondary.metadata()->realColumnIndex (col.foreign_key_);
-        if (key_col == -1) {
-            DBMODEL_DEBUGM("Key column %s was not "
-                           "found in table %s\n",
-                           TMP_A(col.foreign_key_),
-                           TMP_A(secondary.metadata()->tableName()));
-        }
+    DbModelCol & col = mapping_[section];
+    col.label_ = value.toString ();
+    return true;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The table does not own the lookup; it only holds a reference acquired
+ * from DbModelManager and released in `destroy()`.
+ *
+ * @param value the lookup to use; may be NULL
+ */
+void DbModelTbl::setLookup (DbModelLookup * value)
+{
+    lookup_ = value;
+    model_ = (value == NULL ? NULL : value->sqlModel ());
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Filters and sort orders are applied on the model, so they would be
+ * visible in all models that share the lookup. Before changing them
+ * the table acquires a lookup of its own.
+ *
+ * @param db the database that holds the table
+ * @return false if a new lookup could not be created
+ */
+bool DbModelTbl::detachLookup (DbStruct * db)
+{
+    bool b_ret = false;
+    for (;;) {
+        if ((lookup_ == NULL) || !lookup_->isShared ()) {
+            b_ret = true;
+            break;
+        }
+
+        DbModelLookup * own = DbModelManager::acquireLookup (
+                    db, meta_, false, lookup_->mode ());
+        if (own == NULL) {
+            DBMODEL_DEBUGM("Can't create private lookup for table %s\n",
+                           TMP_A(tableName ()));
+            break;
+        }
+
+        replaceLookup (own);
+        b_ret = true;
+        break;
+    }
+    return b_ret;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The integer key columns registered by the foreign columns are
+ * registered with the new lookup. The refresh policy is also carried
+ * over, unless the new lookup is already used by other tables. A
+ * private lookup may have a filter and a sort order set by the user;
+ * these are applied to the new one if it is also private. Nothing is
+ * selected.
+ *
+ * @param other the lookup to use, acquired from DbModelManager
+ */
+void DbModelTbl::replaceLookup (DbModelLookup * other)
+{
+    QSqlTableModel * next = (other == NULL ? NULL : other->sqlModel ());
+    if ((lookup_ != NULL) && !lookup_->isShared () && (model_ != NULL) &&
+            (next != NULL) && !other->isShared ()) {
+        next->setFilter (model_->filter ());
+        if (order_col_ != -1) {
+            next->setSort (order_col_, order_dir_);
+        }
+    }
+    if (lookup_ != NULL) {
+        if (other != NULL) {
+            foreach (int kcol, lookup_->integerKeys ()) {
+                other->setIntegerKey (kcol);
+            }
+            if (!other->isShared () || (other->refCount () == 1)) {
+                other->setRefreshPolicy (
+                            lookup_->refreshPolicy (),
+                            lookup_->refreshArgument ());
+            }
+        }
+        DbModelManager::releaseLookup (lookup_);
+    }
+    setLookup (other);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The column is remembered so that the order survives a change
+ * of lookup (`replaceLookup()`).
+ *
+ * @param real_col the (real) index of the column
+ * @param order the direction
+ */
+void DbModelTbl::setSort (int real_col, Qt::SortOrder order)
+{
+    if (model_ == NULL)
+        return;
+    order_col_ = real_col;
+    order_dir_ = order;
+    model_->sort (real_col, order);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Shared lookups are not selected again if this already happened
+ * in current pass of the event loop (unless \b b_force is true).
+ *
+ * @param b_force select even if the lookup is fresh
+ * @return false if there's no model or the select failed
+ */
+bool DbModelTbl::select (bool b_force) const
+{
+    if (lookup_ != NULL)
+        return lookup_->select (b_force);
+    if (model_ == NULL)
+        return false;
+    return model_->select ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Key indexes are kept by the lookup, so only secondary tables
+ * can be searched.
+ *
+ * @param kcol the (real) index of the column that holds the keys
+ * @param key the value to search for
+ * @return the index of the row or -1 if the key was not found
+ */
+int DbModelTbl::findRow (int kcol, const QVariant &key) const
+{
+    if (lookup_ == NULL)
+        return -1;
+    return lookup_->findRow (kcol, key);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void DbModelTbl::clearKeyIndex () const
+{
+    if (lookup_ != NULL)
+        lookup_->clearKeyIndex ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+QVariant DbModelTbl::getRemoteData (
+        const DbModelPrivate* mp, int kcol, int dcol,
+        const QVariant &key) const
+{
+    int row = findRow (kcol, key);
+    if (row == -1)
+        return QVariant ();
+    return remoteData (mp, row, dcol);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * @param mp the model that requests the data
+ * @param row the row in this table; -1 yields a null value
+ * @param dcol the column to retrieve
+ * @return the value (not formatted)
+ */
+QVariant DbModelTbl::remoteData (
+        const DbModelPrivate* mp, int row, int dcol) const
+{
+    QVariant result;
+    if (row != -1) {
+        const DbModelCol & column = mapping_.at (dcol);
+        const DbColumn & col_meta = column.original_;
+
+        int role = Qt::EditRole;
+        if (col_meta.isDynamic() || col_meta.isForeignKey ())
+            role = Qt::DisplayRole;
+        result = data (
+                    mp, row, dcol, role);
+    }
+    return result;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * A foreign key column and all virtual columns that reference it show
+ * values from the same row in secondary table. That row is
+ * searched once for each row in this table and the result is
+ * kept until the rows of either table change (main table is cleared
+ * explicitly by DbModelPrivate, secondary tables use the generation)
+ * or the secondary table gets another lookup. New rows in the
+ * secondary table only drop the rows that were not found.
+ *
+ * @param row the row in this table
+ * @param column the foreign column
+ * @param key the key stored in the row
+ * @return the row in secondary table or -1 if not found
+ */
+int DbModelTbl::resolveRow (
+        int row, const DbModelCol & column, const QVariant &key) const
+{
+    int group = column.original_.isVirtual () ?
+                column.original_.virtrefcol_ : column.user_index_;
+    RowCache & cache = resolved_[group];
+
+    const DbModelLookup * lookup = column.table_->lookup ();
+    int gen = column.table_->generation ();
+    int missing_gen = column.table_->missingGeneration ();
+    int own_gen = generation ();
+    int i_max = rowCount ();
+    if ((cache.lookup_ != lookup) ||
+            (cache.generation_ != gen) || (cache.own_generation_ != own_gen)) {
+        cache.rows_.fill (DBMODEL_ROW_UNRESOLVED, i_max);
+        cache.lookup_ = lookup;
+        cache.generation_ = gen;
+        cache.missing_generation_ = missing_gen;
+        cache.own_generation_ = own_gen;
+    } else if (cache.missing_generation_ != missing_gen) {
+        int j_max = cache.rows_.count ();
+        for (int j = 0; j < j_max; ++j) {
+            if (cache.rows_.at (j) == -1)
+                cache.rows_[j] = DBMODEL_ROW_UNRESOLVED;
+        }
+        cache.missing_generation_ = missing_gen;
+    }
+    if (cache.rows_.count () < i_max) {
+        int old_max = cache.rows_.count ();
+        cache.rows_.resize (i_max);
+        for (int i = old_max; i < i_max; ++i) {
+            cache.rows_[i] = DBMODEL_ROW_UNRESOLVED;
+        }
+    }
+    if ((row < 0) || (row >= cache.rows_.count ()))
+        return column.table_->findRow (column.t_key_, key);
+
+    int & result = cache.rows_[row];
+    if (result == DBMODEL_ROW_UNRESOLVED) {
+        result = column.table_->findRow (column.t_key_, key);
+    }
+    return result;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Should be called each time the rows of this table change; the
+ * columnar store, if any, is also updated.
+ *
+ * @param row the row that changed or -1 for all rows
+ */
+void DbModelTbl::clearResolved (int row) const
+{
+    if (row == -1) {
+        resolved_.clear ();
+        nulls_.clear ();
+        dynamic_.clear ();
+        if (store_ != NULL)
+            store_->clear ();
+        return;
+    }
+    dynamic_.remove (row);
+    if ((store_ != NULL) && (row < store_->rowCount ())) {
+        store_->reloadRow (model_, row);
+    }
+    QHash<int, QBitArray>::iterator n_iter;
+    for (n_iter = nulls_.begin (); n_iter != nulls_.end (); ++n_iter) {
+        if (row < n_iter.value ().size ()) {
+            n_iter.value ().setBit (row, value (row, n_iter.key ()).isNull ());
+        }
+    }
+    QHash<int, RowCache>::iterator iter = resolved_.begin ();
+    QHash<int, RowCache>::iterator iter_end = resolved_.end ();
+    for (; iter != iter_end; ++iter) {
+        if (row < iter.value ().rows_.count ()) {
+            iter.value ().rows_[row] = DBMODEL_ROW_UNRESOLVED;
+        }
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The rows are split in fixed blocks of DBMODEL_DYNAMIC_BATCH rows
+ * and the batch callback is asked for all the rows in the block
+ * of `row` that are not cached yet, so that a view that shows
+ * a window of rows triggers one or two calls.
+ *
+ * @param mp the model that owns this table
+ * @param row the row that is requested
+ * @param col the user index of a dynamic column
+ * @param role the role
+ * @param result receives the value for `row`
+ * @return false if the column has no batch callback or the callback
+ * failed; the caller should use the per-row callback
+ */
+bool DbModelTbl::batchData (
+        const DbModelPrivate* mp, int row, int col, int role,
+        QVariant & result) const
+{
+    bool b_ret = false;
+    for (;;) {
+        DbColBatchKb kb = mapping_.at (col).batchCallback ();
+        if (kb == NULL)
+            break;
+
+        int first = row - (row % DBMODEL_DYNAMIC_BATCH);
+        int last = qMin (first + DBMODEL_DYNAMIC_BATCH, rowCount ()) - 1;
+        QPair<int, int> dyn_key (col, role);
+        QVector<DbModelRow> rows;
+        rows.reserve (last - first + 1);
+        for (int i = first; i <= last; ++i) {
+            if (i != row) {
+                QHash<int, DynamicRow>::const_iterator dyn_iter =
+                        dynamic_.constFind (i);
+                if ((dyn_iter != dynamic_.constEnd ()) &&
+                        dyn_iter.value ().contains (dyn_key)) {
+                    continue;
+                }
+            }
+            rows.append (rowView (i));
+        }
+
+        QList<QVariant> values = kb (
+                    *meta_, rows, role, mp->parentDbModel ());
+        if (values.count () != rows.count ()) {
+            DBMODEL_DEBUGM("Batch callback for column %d returned %d "
+                           "values for %d rows\n",
+                           col, values.count (), rows.count ());
+            break;
+        }
+
+        int i_max = rows.count ();
+        for (int i = 0; i < i_max; ++i) {
+            int i_row = rows.at (i).row ();
+            dynamic_[i_row].insert (dyn_key, values.at (i));
+            if (i_row == row) {
+                result = values.at (i);
+            }
+        }
+        b_ret = true;
+        break;
+    }
+    return b_ret;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The callbacks receive the model, so their results may depend on
+ * any value in the row; DbModelPrivate calls this for the rows
+ * covered by each `dataChanged()` signal.
+ *
+ * @param first the first row to forget or -1 for all rows
+ * @param last the last row to forget (inclusive)
+ */
+void DbModelTbl::clearDynamic (int first, int last) const
+{
+    if ((first == -1) || (dynamic_.isEmpty ())) {
+        dynamic_.clear ();
+        return;
+    }
+    if (last - first + 1 <= dynamic_.count ()) {
+        for (int i = first; i <= last; ++i) {
+            dynamic_.remove (i);
+        }
+    } else {
+        QHash<int, DynamicRow>::iterator iter = dynamic_.begin ();
+        while (iter != dynamic_.end ()) {
+            if ((iter.key () >= first) && (iter.key () <= last)) {
+                iter = dynamic_.erase (iter);
+            } else {
+                ++iter;
+            }
+        }
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The result is the same as testing `data()` with Qt::EditRole. The flags
+ * for a column are computed the first time the column is tested,
+ * for all the rows fetched so far, and are extended as the model
+ * fetches more rows. Dynamic columns are always computed.
+ *
+ * @param mp the model that owns this table
+ * @param row the row
+ * @param col the user index of the column
+ * @return true if the value is null or the indexes are not valid
+ */
+bool DbModelTbl::isNullCell (const DbModelPrivate* mp, int row, int col) const
+{
+    if (!isColIndexValid (col) || (model_ == NULL))
+        return true;
+
+    const DbModelCol & column = mapping_.at (col);
+    if (column.original_.isDynamic ())
+        return data (mp, row, col, Qt::EditRole).isNull ();
+
+    int real_col = column.original_.isVirtual () ?
+                keyRealIndex (column) : column.mainTableRealIndex ();
+    QBitArray & bits = nulls_[real_col];
+    int i_max = rowCount ();
+    if (bits.size () < i_max) {
+        int old_max = bits.size ();
+        bits.resize (i_max);
+        for (int i = old_max; i < i_max; ++i) {
+            bits.setBit (i, value (i, real_col).isNull ());
+        }
+    }
+    if ((row < 0) || (row >= bits.size ()))
+        return true;
+    return bits.testBit (row);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+int DbModelTbl::generation () const
+{
+    if (lookup_ == NULL)
+        return 0;
+    return lookup_->generation ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+int DbModelTbl::missingGeneration () const
+{
+    if (lookup_ == NULL)
+        return 0;
+    return lookup_->missingGeneration ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Rows show placeholders while the keys they reference are loaded
+ * by an asynchronous secondary table.
+ *
+ * @param first receives first row in the range
+ * @param last receives last row in the range
+ * @return false if no row shows placeholders
+ */
+bool DbModelTbl::takeWaiting (int & first, int & last) const
+{
+    first = waiting_first_;
+    last = waiting_last_;
+    waiting_first_ = -1;
+    waiting_last_ = -1;
+    return first != -1;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The work is done by the accessor chosen for the column by
+ * `constructAccessors()`.
+ */
+QVariant DbModelTbl::data (
+        const DbModelPrivate* mp, int row, int col, int role,
+        const QSqlRecord * rec) const
+{
+#ifdef DBMODEL_DEBUG
+    if (col == 6) {
+        if (role == Qt::DisplayRole) {
+            int kkk = 0;
+        }
+    }
+
+#endif
+
+    QVariant result;
+    for (;;) {
+        if (!isColIndexValid (col)) {
+            break;
+        }
+
+        // Degenerate case.
+        if (model_ == NULL) {
+            break;
+        }
+
+        assert(col < accessors_.count ());
+        result = (this->*accessors_.at (col)) (mp, row, col, role, rec);
+        break;
+    }
+    return result;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The callback may be expensive so its results are kept
+ * until the row changes.
+ */
+QVariant DbModelTbl::dynamicData (
+        const DbModelPrivate* mp, int row, int col, int role,
+        const QSqlRecord * rec) const
+{
+    QVariant result;
+    QPair<int, int> dyn_key (col, role);
+    QHash<int, DynamicRow>::const_iterator dyn_iter =
+            dynamic_.constFind (row);
+    if (dyn_iter != dynamic_.constEnd ()) {
+        DynamicRow::const_iterator cell =
+                dyn_iter.value ().constFind (dyn_key);
+        if (cell != dyn_iter.value ().constEnd ()) {
+            return cell.value ();
+        }
+    }
+    if (batchData (mp, row, col, role, result))
+        return result;
+
+    const DbModelCol & column = mapping_.at (col);
+    DbColRowKb row_kb = column.rowCallback ();
+    if (row_kb != NULL) {
+        result = row_kb (*meta_, rowView (row), role, mp->parentDbModel ());
+    } else {
+        QSqlRecord own_rec;
+        if (rec == NULL) {
+            own_rec = record (row);
+            rec = &own_rec;
+        }
+        result = column.original_.kbData (
+                    *meta_, *rec, role, mp->parentDbModel ());
+    }
+    // the callback may have changed the hash so look it up again
+    dynamic_[row].insert (dyn_key, result);
+    return result;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The branches on template arguments are resolved at compile time, so
+ * each kind of column only runs the code it needs.
+ *
+ * Only display and edit roles are serviced; edit role gets
+ * the stored value (the key, for foreign columns).
+ */
+template <bool B_VIRTUAL, int SOURCE>
+QVariant DbModelTbl::storedData (
+        const DbModelPrivate* mp, int row, int col, int role,
+        const QSqlRecord *) const
+{
+    if ((role != Qt::DisplayRole) && (role != Qt::EditRole))
+        return QVariant ();
+
+    const DbModelCol & column = mapping_.at (col);
+    QVariant result;
+    if (B_VIRTUAL) {
+        // if this is a virtual column we need the index of the original column
+        const DbColumn & col_meta = column.original_;
+        assert(col_meta.virtrefcol_ >= 0);
+        assert(col_meta.virtrefcol_ < columnCount ());
+        // get the key in foreign table
+        const DbModelCol & ref_col = columnData (col_meta.virtrefcol_);
+        result = value (row, ref_col.mainTableRealIndex ());
+    } else {
+        // Get the value stored on this column (may be actual
+        // value or the key in a foreign table.
+        result = value (row, column.mainTableRealIndex ());
+    }
+
+    // For edit role we return raw data.
+    if (role == Qt::EditRole)
+        return result;
+
+    if (SOURCE == VS_LOCAL) {
+        // If the column is not foreign we have the result.
+        return column.formattedData (result);
+    } else if (SOURCE == VS_JOINED) {
+        // The main query retrieved the value for us.
+        result = value (row, column.join_col_);
+        if (result.isNull())
+            return result;
+        return column.table_->columnData (column.t_display_).
+                formattedData (result);
+    } else {
+        return lookupData (mp, row, column, result);
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * @param mp the model that owns this table
+ * @param row the row in this table
+ * @param column the foreign column
+ * @param key the value stored by the column
+ * @return the formatted value or a placeholder
+ */
+QVariant DbModelTbl::lookupData (
+        const DbModelPrivate* mp, int row, const DbModelCol & column,
+        const QVariant & key) const
+{
+    QVariant result = key;
+
+    // Composite keys are made up of the values in more than one column.
+    if (column.isComposite ()) {
+        result = keyValue (row, column);
+    }
+
+    // On-demand tables load the keys as they are needed.
+    DbModelLookup * lookup = column.table_->lookup ();
+    if ((lookup != NULL) && !lookup->isKnown (column.t_key_, result)) {
+        if (!lookup->isPending (column.t_key_, result)) {
+            fetchRemoteKeys (row, column);
+        }
+        // Asynchronous tables don't have the row yet.
+        if (lookup->isAsync () &&
+                !lookup->isKnown (column.t_key_, result)) {
+            if ((waiting_first_ == -1) || (row < waiting_first_))
+                waiting_first_ = row;
+            if (row > waiting_last_)
+                waiting_last_ = row;
+            return DbModelManager::getPlaceholder ();
+        }
+    }
+
+    // All columns that use same key share the row in secondary table.
+    result = column.table_->remoteData (
+                mp, resolveRow (row, column, result), column.t_display_);
+    if (result.isNull())
+        return result;
+    return column.table_->columnData (column.t_display_).
+            formattedData (result);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Called once the columns are known and again when the joins change.
+ */
+void DbModelTbl::constructAccessors ()
+{
+    int i_max = mapping_.count ();
+    accessors_.resize (i_max);
+    for (int i = 0; i < i_max; ++i) {
+        const DbModelCol & column = mapping_.at (i);
+        const DbColumn & col_meta = column.original_;
+        Accessor & acc = accessors_[i];
+        if (col_meta.isDynamic ()) {
+            acc = &DbModelTbl::dynamicData;
+        } else if (col_meta.isVirtual ()) {
+            if (!column.isForeign ()) {
+                acc = &DbModelTbl::storedData<true, VS_LOCAL>;
+            } else if (column.isJoined ()) {
+                acc = &DbModelTbl::storedData<true, VS_JOINED>;
+            } else {
+                acc = &DbModelTbl::storedData<true, VS_LOOKUP>;
+            }
+        } else {
+            if (!column.isForeign ()) {
+                acc = &DbModelTbl::storedData<false, VS_LOCAL>;
+            } else if (column.isJoined ()) {
+                acc = &DbModelTbl::storedData<false, VS_JOINED>;
+            } else {
+                acc = &DbModelTbl::storedData<false, VS_LOOKUP>;
+            }
+        }
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+const DbModelCol &DbModelTbl::columnData(int index) const
+{
+    return mapping_.at (index);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+int DbModelTbl::toRealIndex (int value) const
+{
+    if (meta_ == NULL) {
+        return NULL;
+    }
+    return meta_->toRealIndex (value);
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void DbModelTbl::constructColumns (DbModelPrivate* mp)
+{
+    mapping_.clear();
+    if (meta_ == NULL)
+        return;
+
+    int i_max = meta_->columnCount ();
+
+    // There's going to be at least this many columns.
+    mapping_.reserve (i_max);
+
+    // create the columns as we go
+    int col_idx = 0;
+    for (int i = 0; i < i_max; ++i) {
+        DbColumn col = meta_->columnCtor (i);
+        if (col.isForeignKey ()) {
+            addForeignKeyColumn (col, col_idx, mp);
+        } else {
+            DbModelCol loc_col (col, col_idx, *this);
+            loc_col.t_display_ = col.columnId ();
+//            loc_col.t_display_ = col.columnRealId();
+            if (loc_col.t_display_  == -1) {
+                DBMODEL_DEBUGM("Cannot use virtual column as display "
+                               "(column %s - %d)\n",
+                               TMP_A(col.columnName()), i);
+                continue;
+            }
+            loc_col.label_ = loc_col.original_.columnLabel ();
+            //setHeaderData(col_idx, Qt::Vertical, QString("X %1").arg (col_idx));
+            mapping_.append (loc_col);
+            ++col_idx;
+        }
+    }
+
+    constructStyles ();
+    constructAccessors ();
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Read-only columns are shown in a lighter color. The alignment is
+ * left to default processing unless changed with `setColumnAlignment()`.
+ */
+void DbModelTbl::constructStyles ()
+{
+    compileFormats ();
+    int i_max = mapping_.count ();
+    styles_.resize (i_max);
+    for (int i = 0; i < i_max; ++i) {
+        ColStyle & style = styles_[i];
+        style.editable_ = !mapping_.at (i).original_.readOnly ();
+        if (style.editable_) {
+            style.text_color_ = QVariant ();
+        } else {
+            style.text_color_ = QColor (Qt::darkGray);
+        }
+        style.alignment_ = QVariant ();
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The strings used by the formats are translated here, so this should
+ * be called again when the language changes (DbModel::reloadHeaders()).
+ */
+void DbModelTbl::compileFormats ()
+{
+    int i_max = mapping_.count ();
+    for (int i = 0; i < i_max; ++i) {
+        mapping_[i].compileFormat ();
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * @param col the user index of the column
+ * @param value a Qt::Alignment or an invalid value for default processing
+ * @return false if the index is not valid
+ */
+bool DbModelTbl::setColumnAlignment (int col, const QVariant & value)
+{
+    if ((col < 0) || (col >= styles_.count ()))
+        return false;
+    styles_[col].alignment_ = value;
+    return true;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+void DbModelTbl::addForeignKeyColumn (
+        const DbColumn & col, int & col_idx, DbModelPrivate* mp)
+{
+    DBMODEL_TRACE_ENTRY;
+
+    // attempt to locate the secondary table in the database
+    const DbModelTbl & secondary = mp->table (col.foreign_table_);
+    QStringList key_names = col.foreign_key_.split (',', QString::SkipEmptyParts);
+    QString key_name = key_names.value (0).trimmed ();
+    int key_col = -1;
+    if (secondary.isValid()) {
+        key_col = secondary.metadata()->realColumnIndex (key_name);
+        if (key_col == -1) {
+            DBMODEL_DEBUGM("Key column %s was not "
+                           "found in table %s\n",
+                           TMP_A(key_name),
+                           TMP_A(secondary.metadata()->tableName()));
+        } else if ((secondary.lookup () != NULL) && (key_names.count () == 1)) {
+            // integer keys get a faster index
+            int key_vcol = secondary.metadata()->columnIndex (
+                        key_name);
+            if ((key_vcol != -1) && isIntegerColumn (
+                        secondary.metadata()->columnCtor (key_vcol))) {
+                secondary.lookup ()->setIntegerKey (key_col);
+            }
+        }
     }
 
     // new column to be added to mapping_ array
     DbModelCol loc_col (col, col_idx, secondary);
     if (secondary.isValid() && (key_col != -1)) {
         loc_col.t_primary_ = key_col;
+        loc_col.t_key_ = key_col;
+        if (key_names.count () > 1) {
+            addCompositeKey (loc_col, key_names);
+        }
 //        loc_col.t_display_ = secondary.metadata()->realColumnIndex (
 //                    col.foreign_ref_);
         loc_col.t_display_ = secondary.metadata()->columnIndex (
@@ -440,6 +1432,219 @@ void DbModelTbl::addForeignKeyColumn (
 }
 /* ========================================================================= */
 
+/* ------------------------------------------------------------------------- */
+/**
+ * The first entry in the list is the key column for `column`; each
+ * of the others is either the name of a column present in both tables
+ * or `local=remote`. If any of them can't be found the column is
+ * resolved using only the first key column.
+ *
+ * @param column the new foreign column
+ * @param key_names the names of the key columns in secondary table
+ */
+void DbModelTbl::addCompositeKey (
+        DbModelCol & column, const QStringList & key_names)
+{
+    DBMODEL_TRACE_ENTRY;
+    const DbModelTbl * secondary = column.table_;
+    for (;;) {
+        if (secondary->lookup () == NULL) {
+            DBMODEL_DEBUGM("Composite keys need a lookup for table %s\n",
+                           TMP_A(secondary->tableName ()));
+            break;
+        }
+
+        QList<int> remote;
+        QList<int> local;
+        remote.append (column.t_primary_);
+        local.append (column.original_.isVirtual () ?
+                          -1 : column.mainTableRealIndex ());
+
+        int i_max = key_names.count ();
+        for (int i = 1; i < i_max; ++i) {
+            QString local_name = key_names.at (i).section ('=', 0, 0).trimmed ();
+            QString remote_name = key_names.at (i).section ('=', -1).trimmed ();
+            int remote_col = secondary->metadata ()->realColumnIndex (remote_name);
+            int local_col = metadata ()->realColumnIndex (local_name);
+            if ((remote_col == -1) || (local_col == -1)) {
+                DBMODEL_DEBUGM("Key pair %s was not found in tables %s, %s\n",
+                               TMP_A(key_names.at (i)),
+                               TMP_A(tableName ()),
+                               TMP_A(secondary->tableName ()));
+                remote.clear ();
+                break;
+            }
+            remote.append (remote_col);
+            local.append (local_col);
+        }
+        if (remote.isEmpty ()) {
+            break;
+        }
+
+        column.t_key_ = secondary->lookup ()->tupleKey (remote);
+        column.local_keys_ = local;
+        column.remote_keys_ = remote;
+        break;
+    }
+    DBMODEL_TRACE_EXIT;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * The ids of composite keys are assigned by the lookup of the secondary
+ * table, so they are obtained again each time that table gets another
+ * lookup; the columns of the keys are kept in `remote_keys_`.
+ *
+ * @param secondary the table that got another lookup
+ */
+void DbModelTbl::registerKeys (const DbModelTbl * secondary)
+{
+    DbModelLookup * lookup = secondary->lookup ();
+    if (lookup == NULL)
+        return;
+
+    int i_max = mapping_.count ();
+    for (int i = 0; i < i_max; ++i) {
+        DbModelCol & column = mapping_[i];
+        if ((column.table_ == secondary) && !column.remote_keys_.isEmpty ()) {
+            column.t_key_ = lookup->tupleKey (column.remote_keys_);
+        }
+    }
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Only the columns that show a plain column from the secondary table
+ * through a single key column can be joined; the ones that show
+ * dynamic, virtual or foreign columns keep using the secondary table.
+ *
+ * @param sql the model used for this (main) table
+ */
+void DbModelTbl::setupJoins (DbModelSql * sql)
+{
+    DBMODEL_TRACE_ENTRY;
+    sql->clearJoins ();
+
+    int i_max = mapping_.count ();
+    for (int i = 0; i < i_max; ++i) {
+        DbModelCol & column = mapping_[i];
+        column.join_col_ = -1;
+        if (!column.isForeign () || column.isComposite ())
+            continue;
+        // a list whose registration as composite key failed would
+        // join on part of the key and repeat the rows of this table
+        if (column.original_.foreign_key_.contains (','))
+            continue;
+
+        const DbModelTbl * secondary = column.table_;
+        const DbModelCol & display = secondary->columnData (column.t_display_);
+        if (display.isForeign () ||
+                display.original_.isDynamic () ||
+                display.original_.isVirtual ()) {
+            continue;
+        }
+
+        column.join_col_ = sql->addJoin (
+                    keyRealIndex (column),
+                    secondary->tableName (),
+                    column.foreignKeyName (),
+                    display.original_.columnName ());
+    }
+    constructAccessors ();
+    field_names_.clear ();
+    field_index_.clear ();
+
+    DBMODEL_TRACE_EXIT;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Undoes `setupJoins()`; the statement of main table no longer
+ * retrieves the columns of secondary tables.
+ *
+ * @param sql the model of this (main) table
+ */
+void DbModelTbl::clearJoins (DbModelSql * sql)
+{
+    DBMODEL_TRACE_ENTRY;
+    sql->clearJoins ();
+
+    int i_max = mapping_.count ();
+    for (int i = 0; i < i_max; ++i) {
+        mapping_[i].join_col_ = -1;
+    }
+    constructAccessors ();
+    field_names_.clear ();
+    field_index_.clear ();
+
+    DBMODEL_TRACE_EXIT;
+}
+/* ========================================================================= */
+
+/* ------------------------------------------------------------------------- */
+/**
+ * Virtual columns use the key of the column they reference. Only
+ * the columns that show a plain column from the secondary table can
+ * be sorted this way, same as for joins.
+ *
+ * @param sql the model of this (main) table
+ * @param col user index of a foreign column
+ * @param order the direction
+ * @return false if the column can't be sorted by the database
+ */
+bool DbModelTbl::setupOrder (
+        DbModelSql * sql, int col, Qt::SortOrder order) const
+{
+    bool b_ret = false;
+    for (;;) {
+        if (!isColIndexValid (col))
+            break;
+        const DbModelCol & column = mapping_.at (col);
+        if (!column.isForeign ())
+            break;
+
+        const DbModelTbl * secondary = column.table_;
+        const DbModelCol & display = secondary->columnData (column.t_display_);
+        if (display.isForeign () ||
+                display.original_.isDynamic () ||
+                display.original_.isVirtual ()) {
+            DBMODEL_DEBUGM("Column %d shows a value that is not stored "
+                           "in table %s\n",
+                           col, TMP_A(secondary->tableName ()));
+            break;
+        }
+
+        QList<int> local;
+        QStringList remote;
+        const DbModelCol & owner = column.original_.isVirtual () ?
+                    mapping_.at (column.original_.virtrefcol_) : column;
+        if (owner.local_keys_.isEmpty ()) {
+            local.append (keyRealIndex (column));
+            remote.append (column.foreignKeyName ());
+        } else {
+            local = owner.local_keys_;
+            foreach(int remote_col, owner.remote_keys_) {
+                QString name = secondary->fieldName (remote_col);
+                if (name.isEmpty ()) {
+                    remote.clear ();
+                    break;
+                }
+                remote.append (name);
+            }
+        }
+
+        b_ret = sql->setForeignOrder (
+                    local, secondary->tableName (), remote,
+                    display.original_.columnName (), order);
+        break;
+    }
+    return b_ret;
+}
+/* ========================================================================= */
+
 /*  CLASS    =============================================================== */
 //
 //
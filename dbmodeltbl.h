@@ -25,8 +25,16 @@
 
 #include <dbmodel/dbmodel-config.h>
 #include <dbmodel/dbmodelcol.h>
+#include <dbmodel/dbmodelrow.h>
 #include <dbstruct/dbtaew.h>
 #include <dbstruct/dbcolumn.h>
+#include <QSqlRecord>
+#include <QVariant>
+#include <QStringList>
+#include <QHash>
+#include <QVector>
+#include <QBitArray>
+#include <QPair>
 #if DBSTRUCT_MAJOR_VERSION >= 1
 #include <dbstruct/dbdatatype.h>
 #endif
@@ -40,6 +48,9 @@
 /*  DEFINITIONS    --------------------------------------------------------- */
 
 class DbModelPrivate;
+class DbModelLookup;
+class DbModelSql;
+class DbModelStore;
 
 /*  DEFINITIONS    ========================================================= */
 //
@@ -58,6 +69,74 @@ class DBMODEL_EXPORT DbModelTbl {
 
     friend class DbModelPrivate;
 
+public:
+
+    //! How are the values for foreign columns retrieved.
+    enum ForeignMode {
+        FM_LOOKUP = 0, /**< secondary tables are loaded and searched */
+        FM_JOIN /**< secondary tables are joined by the main query */
+    };
+
+    //! How are the rows of a secondary table loaded.
+    enum LookupMode {
+        LM_FULL = 0, /**< all rows are loaded when the model is selected */
+        LM_ONDEMAND, /**< rows are loaded in batches as their keys are needed */
+        LM_ASYNC /**< same as LM_ONDEMAND but the rows are loaded in
+                      a worker thread while placeholders are shown */
+    };
+
+    //! When is a secondary table selected again.
+    enum RefreshPolicy {
+        RP_ALWAYS = 0, /**< each time the model is selected */
+        RP_TTL, /**< when the rows are older than a number of milliseconds */
+        RP_VERSION, /**< when a query reports a different version */
+        RP_MANUAL /**< only when explicitly requested */
+    };
+
+    //! Properties of a column that are the same for all rows.
+    struct ColStyle {
+        bool editable_; /**< the user may change the values */
+        QVariant text_color_; /**< value for Qt::TextColorRole (invalid
+                                   for default processing) */
+        QVariant alignment_; /**< value for Qt::TextAlignmentRole (invalid
+                                  for default processing) */
+    };
+
+private:
+
+    //! Rows of a secondary table resolved for each row of this table.
+    struct RowCache {
+        QVector<int> rows_; /**< remote row for each local row */
+        const DbModelLookup * lookup_; /**< lookup of the remote table
+                                            when filled */
+        int generation_; /**< generation of the remote table when filled */
+        int missing_generation_; /**< generation of the rows available in
+                                      the remote table when filled */
+        int own_generation_; /**< generation of this table when filled */
+
+        RowCache () :
+            rows_(), lookup_(NULL), generation_(-1),
+            missing_generation_(-1), own_generation_(-1) {}
+    };
+
+    //! Results of dynamic columns for a row, by (user column, role).
+    typedef QHash<QPair<int, int>, QVariant> DynamicRow;
+
+    //! Produces the value of a cell for one kind of column.
+    typedef QVariant (DbModelTbl::*Accessor) (
+            const DbModelPrivate* mp,
+            int row,
+            int col,
+            int role,
+            const QSqlRecord * rec) const;
+
+    //! Where does the value shown by a column that is not dynamic come from.
+    enum ValueSource {
+        VS_LOCAL = 0, /**< the stored value */
+        VS_LOOKUP, /**< a row in a secondary table referenced by the stored key */
+        VS_JOINED /**< a column added to the main query by a join */
+    };
+
     /*  DEFINITIONS    ===================================================== */
     //
     //
@@ -69,6 +148,28 @@ class DBMODEL_EXPORT DbModelTbl {
     QSqlTableModel * model_; /**< the underlying model */
     QList<DbModelCol> mapping_; /**< one entry for each column mapping between
                              user-indexes and internal models */
+    DbModelLookup * lookup_; /**< shared data for secondary tables
+                             (NULL for main table) */
+    mutable QHash<int, RowCache> resolved_; /**< remote rows for each
+                             foreign key column (by user index) */
+    QVector<ColStyle> styles_; /**< one entry for each column in `mapping_` */
+    mutable QHash<int, QBitArray> nulls_; /**< one bit for each row
+                             telling if the value is null, by real index */
+    mutable int waiting_first_; /**< first row that shows placeholders */
+    mutable int waiting_last_; /**< last row that shows placeholders */
+    mutable DbModelStore * store_; /**< typed copy of the rows
+                             (NULL if not enabled, main table only) */
+    mutable QHash<int, DynamicRow> dynamic_; /**< results of the callbacks
+                             for dynamic columns, by row */
+    QVector<Accessor> accessors_; /**< one entry for each column in
+                             `mapping_`, chosen by `constructAccessors()` */
+    mutable QStringList field_names_; /**< names of the columns in the
+                             sql model (loaded when first needed) */
+    mutable QHash<QString, int> field_index_; /**< index of each name
+                             in `field_names_` */
+    int order_col_; /**< real index of the column the model is sorted
+                             on (-1 if not sorted by this table) */
+    Qt::SortOrder order_dir_; /**< direction for `order_col_` */
 
     /*  DATA    ============================================================ */
     //
@@ -121,6 +222,67 @@ public:
         model_ = value;
     }
 
+    //! Shared data for secondary tables (NULL for main table).
+    DbModelLookup * lookup () const {
+        return lookup_; }
+
+    //! Set shared data; the underlying model is also changed.
+    void
+    setLookup (
+            DbModelLookup * value);
+
+    //! Replace a shared lookup with one private to this table.
+    bool
+    detachLookup (
+            DbStruct * db);
+
+    //! Use another lookup; the reference to current one is released.
+    void
+    replaceLookup (
+            DbModelLookup * other);
+
+    //! Sort the underlying model on one of its columns.
+    void
+    setSort (
+            int real_col,
+            Qt::SortOrder order);
+
+    //! Select the underlying model.
+    bool
+    select (
+            bool b_force = false) const;
+
+    //! How are the rows loaded (always LM_FULL for main table).
+    LookupMode
+    lookupMode () const;
+
+    //! Change the way rows are loaded (secondary tables only).
+    bool
+    setLookupMode (
+            DbStruct * db,
+            LookupMode mode);
+
+    //! When are the rows selected again (always RP_ALWAYS for main table).
+    RefreshPolicy
+    refreshPolicy () const;
+
+    //! Change the policy for selecting the rows (secondary tables only).
+    bool
+    setRefreshPolicy (
+            RefreshPolicy value,
+            const QVariant & argument = QVariant ());
+
+    //! Tell if the rows are read from a columnar copy.
+    bool
+    hasColumnarStore () const {
+        return store_ != NULL;
+    }
+
+    //! Read the rows from a columnar copy instead of the sql model.
+    void
+    setColumnarStore (
+            bool b_enable);
+
     //! Get the column for a particular index.
     const DbColumn & column (int colidx) const;
 
@@ -142,6 +304,28 @@ public:
     columnCallback (
             int column_index) const;
 
+    //! Set the callback that computes many rows of a column at once.
+    bool
+    setBatchCallback (
+            int column_index,
+            DbColBatchKb value);
+
+    //! Get the callback that computes many rows of a column at once.
+    DbColBatchKb
+    batchCallback (
+            int column_index) const;
+
+    //! Set the callback that computes a column from a row view.
+    bool
+    setRowCallback (
+            int column_index,
+            DbColRowKb value);
+
+    //! Get the callback that computes a column from a row view.
+    DbColRowKb
+    rowCallback (
+            int column_index) const;
+
     //! Get the column for a particular index.
     QString tableName () const {
         if (meta_ == NULL) return QString ();
@@ -156,13 +340,47 @@ public:
     int
     rowCount () const;
 
-    //! Data from the sql model.
+    //! Raw value in a cell; column is a real index.
+    QVariant
+    value (
+            int row,
+            int col) const;
+
+    //! All the values in a row.
+    QSqlRecord
+    record (
+            int row) const;
+
+    //! A view of a row that reads the values in place.
+    DbModelRow
+    rowView (
+            int row) const {
+        return DbModelRow (this, row);
+    }
+
+    //! Number of columns in the sql model.
+    int
+    fieldCount () const;
+
+    //! The real index of a column in the sql model by its name.
+    int
+    fieldIndex (
+            const QString & name) const;
+
+    //! The name of a column in the sql model.
+    QString
+    fieldName (
+            int field) const;
+
+    //! Data from the sql model; `rec` is the record for the row,
+    //! if the caller already has it.
     QVariant
     data (
             const DbModelPrivate* mp,
             int row,
             int column,
-            int role = Qt::DisplayRole) const;
+            int role = Qt::DisplayRole,
+            const QSqlRecord * rec = NULL) const;
 
     //! Get the model data regarding a column; index is a real index.
     const DbModelCol &
@@ -194,6 +412,87 @@ public:
             int dcol,
             const QVariant &key) const;
 
+    //! The value to display for a row found by `findRow()`.
+    QVariant
+    remoteData (
+            const DbModelPrivate* mp,
+            int row,
+            int dcol) const;
+
+    //! The row in secondary table referenced by a row in this table.
+    int
+    resolveRow (
+            int row,
+            const DbModelCol & column,
+            const QVariant &key) const;
+
+    //! The properties of a column that do not depend on the row (NULL if
+    //! the index is not valid).
+    const ColStyle *
+    columnStyle (
+            int col) const {
+        return ((col >= 0) && (col < styles_.count ())) ?
+                    styles_.constData () + col : NULL;
+    }
+
+    //! Change the alignment of a column (invalid value for default).
+    bool
+    setColumnAlignment (
+            int col,
+            const QVariant & value);
+
+    //! Tell if the raw (edit) value of a cell is null.
+    bool
+    isNullCell (
+            const DbModelPrivate* mp,
+            int row,
+            int col) const;
+
+    //! Forget resolved rows and null flags (all of them if row is -1).
+    void
+    clearResolved (
+            int row = -1) const;
+
+    //! Changes each time the rows are renumbered or their keys change.
+    int
+    generation () const;
+
+    //! Changes each time new rows are loaded.
+    int
+    missingGeneration () const;
+
+    //! Compute a dynamic column for the block of rows around a row.
+    bool
+    batchData (
+            const DbModelPrivate* mp,
+            int row,
+            int col,
+            int role,
+            QVariant & result) const;
+
+    //! Forget the results of dynamic columns in a range of rows
+    //! (all of them if first is -1).
+    void
+    clearDynamic (
+            int first = -1,
+            int last = -1) const;
+
+    //! Get and forget the range of rows that show placeholders.
+    bool
+    takeWaiting (
+            int & first,
+            int & last) const;
+
+    //! Find the row that holds a key in a column (-1 if not found).
+    int
+    findRow (
+            int kcol,
+            const QVariant &key) const;
+
+    //! Forget the key indexes (the content of the model changed).
+    void
+    clearKeyIndex () const;
+
 //    //! Get data.
 //    QVariant
 //    data (
@@ -208,6 +507,54 @@ protected:
     constructColumns (
             DbModelPrivate* mp);
 
+    //! Create the properties of the columns that do not depend on the row.
+    void
+    constructStyles ();
+
+public:
+
+    //! Read the format settings of all columns (again).
+    void
+    compileFormats ();
+
+protected:
+
+    //! Choose the function that produces the values for each column.
+    void
+    constructAccessors ();
+
+    //! Read the names of the columns in the sql model.
+    void
+    loadFields () const;
+
+    //! Accessor for dynamic columns.
+    QVariant
+    dynamicData (
+            const DbModelPrivate* mp,
+            int row,
+            int col,
+            int role,
+            const QSqlRecord * rec) const;
+
+    //! Accessor for columns that show the stored value (or the value
+    //! it references); virtual columns use the key of another column.
+    template <bool B_VIRTUAL, int SOURCE>
+    QVariant
+    storedData (
+            const DbModelPrivate* mp,
+            int row,
+            int col,
+            int role,
+            const QSqlRecord * rec) const;
+
+    //! The value in a secondary table referenced by a key.
+    QVariant
+    lookupData (
+            const DbModelPrivate* mp,
+            int row,
+            const DbModelCol & column,
+            const QVariant & key) const;
+
     //! Create all entries for foreign keys and add them to the list.
     void
     addForeignKeyColumn (
@@ -215,6 +562,51 @@ protected:
             int & col_idx,
             DbModelPrivate* mp);
 
+    //! Set up a foreign column with a key made of more than one column.
+    void
+    addCompositeKey (
+            DbModelCol & column,
+            const QStringList & key_names);
+
+    //! The real index of the column that stores the key for a foreign column.
+    int
+    keyRealIndex (
+            const DbModelCol & column) const;
+
+    //! The key stored in a row (a list of values for composite keys).
+    QVariant
+    keyValue (
+            int row,
+            const DbModelCol & column) const;
+
+    //! Load the keys around a row in an on-demand secondary table.
+    void
+    fetchRemoteKeys (
+            int row,
+            const DbModelCol & column) const;
+
+    //! Register the composite keys of the columns that reference a table.
+    void
+    registerKeys (
+            const DbModelTbl * secondary);
+
+    //! Join secondary tables in main query for all foreign columns.
+    void
+    setupJoins (
+            DbModelSql * sql);
+
+    //! Retrieve all foreign values from secondary tables again.
+    void
+    clearJoins (
+            DbModelSql * sql);
+
+    //! Ask main query to sort on the values shown by a foreign column.
+    bool
+    setupOrder (
+            DbModelSql * sql,
+            int col,
+            Qt::SortOrder order) const;
+
     /*  FUNCTIONS    ======================================================= */
     //
     //